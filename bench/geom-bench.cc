@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../lab1/heron.hh"
+#include "../lab2/DistanceStore.hh"
+#include "../lab2/Point.hh"
+#include "../lab2/PointCloud.hh"
+
+/* Times the geometry kernels the labs are built on: point distances,
+   triangle areas and tour lengths.  Inputs are generated, so runs are
+   reproducible.  Each kernel runs over several sizes, layouts and
+   precisions, and the report gives statistics over repeated runs.  The CSV
+   output is meant to be kept and compared across changes. */
+
+// Default problem sizes: L1-, L2/L3- and DRAM-resident working sets.
+static const int DEFAULT_SIZES[] = { 1000, 64000, 1000000 };
+
+// Each timed repetition runs the kernel for at least this many seconds.
+#define MIN_REP_SECONDS 0.01
+
+// One kernel at one size: RUN makes a pass over the input and returns a
+// checksum (so the work cannot be optimized away).  A pass performs OPS
+// operations and must read at least BYTES bytes of input.
+struct Kernel {
+    std::string name;
+    std::string layout;
+    std::string precision;
+    int n;
+    double ops;
+    double bytes;
+    std::function<double()> run;
+};
+
+// Timing statistics of one kernel, in nanoseconds per operation.
+struct Result {
+    int reps;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    double stddev_ns;
+    double gb_per_s;            // from the median
+    double checksum;
+};
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options]" << std::endl
+        << "where options are" << std::endl
+        << "\t-n, --size=N\tinput size to run (repeatable; default 1000, 64000 and 1000000)" << std::endl
+        << "\t-r, --reps=N\ttimed repetitions per kernel (default 10)" << std::endl
+        << "\t-f, --filter=TEXT\tonly run kernels whose name contains TEXT" << std::endl
+        << "\t-m, --max-matrix=N\tlargest size for which distance matrices are built (default 8192)" << std::endl
+        << "\t-o, --output=FILE\talso write the results to FILE as CSV" << std::endl
+        << "\t-l, --label=TEXT\tvalue of the CSV label column, e.g. a commit id" << std::endl;
+    exit(1);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Times KERNEL: one untimed warm-up pass, then REPS repetitions of as many
+    passes as fill MIN_REP_SECONDS. */
+static Result measure(const Kernel &kernel, int reps)
+{
+    Result result;
+    std::vector<double> samples;
+    double checksum = kernel.run();
+    int passes = 1, i, p;
+
+    /* Calibrate the passes per repetition. */
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (p = 0; p < passes; p++)
+        {
+            checksum += kernel.run();
+        }
+        if (secondsSince(start) >= MIN_REP_SECONDS)
+        {
+            break;
+        }
+        passes *= 2;
+    }
+
+    for (i = 0; i < reps; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (p = 0; p < passes; p++)
+        {
+            checksum += kernel.run();
+        }
+        samples.push_back(secondsSince(start) * 1e9 / (passes * kernel.ops));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    result.reps = reps;
+    result.min_ns = samples.front();
+    result.median_ns = reps % 2 == 1 ? samples[reps / 2]
+        : (samples[reps / 2 - 1] + samples[reps / 2]) / 2.0;
+    result.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / reps;
+
+    double var = 0.0;
+    for (double s : samples)
+    {
+        var += (s - result.mean_ns) * (s - result.mean_ns);
+    }
+    result.stddev_ns = reps > 1 ? std::sqrt(var / (reps - 1)) : 0.0;
+
+    /* Bytes per nanosecond are gigabytes per second. */
+    result.gb_per_s = kernel.bytes / kernel.ops / result.median_ns;
+    result.checksum = checksum;
+
+    return result;
+}
+
+/*! N points with coordinates uniform in [0, 1000), drawn from GEN. */
+template<class P>
+static std::vector<P> randomPoints(int n, std::mt19937 &gen)
+{
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    std::vector<P> points;
+
+    points.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        double x = coord(gen), y = coord(gen), z = coord(gen);
+        if constexpr (P::dimension == 2)
+        {
+            points.push_back(P(x, y));
+        }
+        else
+        {
+            points.push_back(P(x, y, z));
+        }
+    }
+
+    return points;
+}
+
+/*! Name of the precision and dimension of point type P, e.g. "f64x3". */
+template<class P>
+static std::string precisionName()
+{
+    return std::string(sizeof(typename P::value_type) == 4 ? "f32" : "f64")
+        + "x" + std::to_string(P::dimension);
+}
+
+/*! Point::distanceTo between consecutive array-of-structures points. */
+template<class P>
+static Kernel distanceKernel(int n, std::mt19937 &gen)
+{
+    auto points = std::make_shared<std::vector<P> >(randomPoints<P>(n + 1, gen));
+    Kernel k;
+
+    k.name = "distanceTo";
+    k.layout = "AoS";
+    k.precision = precisionName<P>();
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * sizeof(P);
+    k.run = [points, n]() {
+        const P *p = points->data();
+        double sum = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            sum += p[i].distanceTo(p[i + 1]);
+        }
+        return sum;
+    };
+
+    return k;
+}
+
+/*! PointCloud::distancesFrom: one point to all points of a SoA cloud. */
+static Kernel distancesFromKernel(int n, std::mt19937 &gen)
+{
+    auto cloud = std::make_shared<PointCloud>(randomPoints<Point>(n, gen));
+    auto out = std::make_shared<std::vector<double> >(n);
+    Kernel k;
+
+    k.name = "distanceTo";
+    k.layout = "SoA";
+    k.precision = "f64x3";
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * 4 * sizeof(double);
+    k.run = [cloud, out, n]() {
+        cloud->distancesFrom(n / 2, out->data());
+        return (*out)[n - 1];
+    };
+
+    return k;
+}
+
+/*! The lab 1 area computation, heronArea() over three distanceTo() calls,
+    on array-of-structures triangles. */
+template<class P>
+static Kernel areaKernel(int n, std::mt19937 &gen)
+{
+    auto points = std::make_shared<std::vector<P> >(randomPoints<P>(3 * n, gen));
+    Kernel k;
+
+    k.name = "computeArea";
+    k.layout = "AoS";
+    k.precision = precisionName<P>();
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * 3 * sizeof(P);
+    k.run = [points, n]() {
+        const P *p = points->data();
+        double sum = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            const P &a = p[3 * i], &b = p[3 * i + 1], &c = p[3 * i + 2];
+            sum += heronArea(a.distanceTo(b), b.distanceTo(c), a.distanceTo(c));
+        }
+        return sum;
+    };
+
+    return k;
+}
+
+/*! The lab 1 batch kernel computeAreas() on a structure-of-arrays batch. */
+static Kernel areasKernel(int n, std::mt19937 &gen)
+{
+    auto tris = std::make_shared<TriangleBatch>();
+    auto areas = std::make_shared<std::vector<double> >(n);
+    std::vector<Point> points = randomPoints<Point>(3 * n, gen);
+    Kernel k;
+
+    tris->reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        double coords[9];
+        for (int v = 0; v < 3; v++)
+        {
+            coords[3 * v] = points[3 * i + v].getX();
+            coords[3 * v + 1] = points[3 * i + v].getY();
+            coords[3 * v + 2] = points[3 * i + v].getZ();
+        }
+        tris->add(coords);
+    }
+
+    k.name = "computeArea";
+    k.layout = "SoA";
+    k.precision = "f64x3";
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * 10 * sizeof(double);
+    k.run = [tris, areas, n]() {
+        computeAreas(*tris, 0, n, areas->data());
+        return (*areas)[n - 1];
+    };
+
+    return k;
+}
+
+/*! A random tour of N cities. */
+static std::shared_ptr<std::vector<int> > randomTour(int n, std::mt19937 &gen)
+{
+    auto order = std::make_shared<std::vector<int> >(n);
+
+    std::iota(order->begin(), order->end(), 0);
+    std::shuffle(order->begin(), order->end(), gen);
+
+    return order;
+}
+
+/*! circuitLength over an array-of-structures point vector, as the lab 2 and
+    lab 3 solvers originally computed it. */
+template<class P>
+static Kernel circuitKernel(int n, std::mt19937 &gen)
+{
+    auto points = std::make_shared<std::vector<P> >(randomPoints<P>(n, gen));
+    auto order = randomTour(n, gen);
+    Kernel k;
+
+    k.name = "circuitLength";
+    k.layout = "AoS";
+    k.precision = precisionName<P>();
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * (sizeof(P) + sizeof(int));
+    k.run = [points, order, n]() {
+        const P *p = points->data();
+        const int *o = order->data();
+        double sum = 0.0;
+        for (int i = 0; i < n - 1; i++)
+        {
+            sum += p[o[i]].distanceTo(p[o[i + 1]]);
+        }
+        return sum + p[o[n - 1]].distanceTo(p[o[0]]);
+    };
+
+    return k;
+}
+
+/*! circuitLength through a DistanceStore of kind KIND over a SoA cloud. */
+static Kernel storeCircuitKernel(int n, DistanceKind kind, const char *layout,
+    const char *precision, double bytes_per_edge, std::mt19937 &gen)
+{
+    auto cloud = std::make_shared<PointCloud>(randomPoints<Point>(n, gen));
+    DistanceOptions opts;
+    opts.kind = kind;
+    std::shared_ptr<DistanceStore> dist(makeDistanceStore(opts, *cloud));
+    auto order = randomTour(n, gen);
+    Kernel k;
+
+    k.name = "circuitLength";
+    k.layout = layout;
+    k.precision = precision;
+    k.n = n;
+    k.ops = n;
+    k.bytes = (double) n * (bytes_per_edge + sizeof(int));
+    k.run = [cloud, dist, order]() {
+        return dist->tourLength(*order);
+    };
+
+    return k;
+}
+
+/*! Every kernel at size N.  Matrix stores are only built up to MAX_MATRIX
+    cities, since they take quadratic memory. */
+static std::vector<Kernel> makeKernels(int n, int max_matrix)
+{
+    std::mt19937 gen(12345 + n);
+    std::vector<Kernel> kernels;
+
+    kernels.push_back(distanceKernel<Point>(n, gen));
+    kernels.push_back(distanceKernel<PointF>(n, gen));
+    kernels.push_back(distanceKernel<Point2>(n, gen));
+    kernels.push_back(distanceKernel<Point2F>(n, gen));
+    kernels.push_back(distancesFromKernel(n, gen));
+
+    kernels.push_back(areaKernel<Point>(n, gen));
+    kernels.push_back(areaKernel<PointF>(n, gen));
+    kernels.push_back(areasKernel(n, gen));
+
+    kernels.push_back(circuitKernel<Point>(n, gen));
+    kernels.push_back(circuitKernel<PointF>(n, gen));
+    kernels.push_back(storeCircuitKernel(n, DISTANCES_POINTS, "SoA", "f64x3",
+        3 * sizeof(double), gen));
+    if (n <= max_matrix)
+    {
+        kernels.push_back(storeCircuitKernel(n, DISTANCES_MATRIX, "matrix",
+            "f64", sizeof(double), gen));
+        kernels.push_back(storeCircuitKernel(n, DISTANCES_FLOAT, "matrix",
+            "f32", sizeof(float), gen));
+        kernels.push_back(storeCircuitKernel(n, DISTANCES_INT16, "matrix",
+            "u16", sizeof(uint16_t), gen));
+    }
+
+    return kernels;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "size", required_argument, nullptr, 'n' },
+        { "reps", required_argument, nullptr, 'r' },
+        { "filter", required_argument, nullptr, 'f' },
+        { "max-matrix", required_argument, nullptr, 'm' },
+        { "output", required_argument, nullptr, 'o' },
+        { "label", required_argument, nullptr, 'l' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<int> sizes;
+    std::string filter, label;
+    const char *output_path = nullptr;
+    int reps = 10, max_matrix = 8192;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:r:f:m:o:l:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            sizes.push_back(atoi(optarg));
+            if (sizes.back() <= 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'r':
+            reps = atoi(optarg);
+            if (reps <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'f':
+            filter = optarg;
+            break;
+
+        case 'm':
+            max_matrix = atoi(optarg);
+            break;
+
+        case 'o':
+            output_path = optarg;
+            break;
+
+        case 'l':
+            label = optarg;
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    if (sizes.empty())
+    {
+        sizes.assign(std::begin(DEFAULT_SIZES), std::end(DEFAULT_SIZES));
+    }
+
+    std::ofstream csv;
+    if (output_path != nullptr)
+    {
+        csv.open(output_path);
+        if (!csv)
+        {
+            std::cerr << "Cannot write " << output_path << std::endl;
+            return 1;
+        }
+        csv << "label,kernel,layout,precision,n,reps,ns_min,ns_median,"
+            << "ns_mean,ns_stddev,gb_per_s" << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+        << std::setw(14) << "kernel" << std::setw(8) << "layout"
+        << std::setw(7) << "prec" << std::setw(9) << "n"
+        << std::setw(10) << "min ns" << std::setw(10) << "median"
+        << std::setw(10) << "mean" << std::setw(9) << "stddev"
+        << std::setw(9) << "GB/s" << std::endl;
+
+    for (int n : sizes)
+    {
+        for (const Kernel &kernel : makeKernels(n, max_matrix))
+        {
+            if (kernel.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            Result r = measure(kernel, reps);
+
+            std::cout << std::setw(14) << kernel.name
+                << std::setw(8) << kernel.layout
+                << std::setw(7) << kernel.precision
+                << std::setw(9) << kernel.n
+                << std::setw(10) << r.min_ns << std::setw(10) << r.median_ns
+                << std::setw(10) << r.mean_ns << std::setw(9) << r.stddev_ns
+                << std::setw(9) << r.gb_per_s;
+            if (!std::isfinite(r.checksum))
+            {
+                std::cout << "  (bad checksum)";
+            }
+            std::cout << std::endl;
+
+            if (csv.is_open())
+            {
+                csv << label << ',' << kernel.name << ',' << kernel.layout
+                    << ',' << kernel.precision << ',' << kernel.n << ','
+                    << r.reps << ',' << r.min_ns << ',' << r.median_ns << ','
+                    << r.mean_ns << ',' << r.stddev_ns << ',' << r.gb_per_s
+                    << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../lab2/DistanceStore.hh"
+#include "../lab2/Point.hh"
+#include "../lab2/PointCloud.hh"
+
+/* Measures tour evaluation throughput in tours per second: one tour at a
+   time through DistanceStore::tourLength() for each kind of store, against
+   TOUR_BATCH tours at a time through tourLengths() on the dense store. */
+
+// Distinct random tours cycled through during a measurement.
+#define TOUR_POOL 64
+
+// Each measurement runs for at least this many seconds.
+#define MIN_SECONDS 0.2
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options]" << std::endl
+        << "where options are" << std::endl
+        << "\t-n, --size=N\tcities per tour (repeatable; default 10, 13, 50, 500 and 5000)" << std::endl;
+    exit(1);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Calls PASS, which measures TOURS_PER_PASS tours and returns a checksum,
+    until MIN_SECONDS have passed.  Returns tours per second. */
+template<class Pass>
+static double toursPerSecond(Pass pass, int tours_per_pass, double &checksum)
+{
+    long long tours = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed;
+
+    do
+    {
+        checksum += pass();
+        tours += tours_per_pass;
+    } while ((elapsed = secondsSince(start)) < MIN_SECONDS);
+
+    return tours / elapsed;
+}
+
+/*! Prints one row per store for tours of N cities. */
+static void benchmark(int n)
+{
+    std::mt19937 gen(12345 + n);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    std::vector<Point> points;
+    int i, t, k;
+
+    for (i = 0; i < n; i++)
+    {
+        points.push_back(Point(coord(gen), coord(gen), coord(gen)));
+    }
+    PointCloud cloud(points);
+
+    /* The tours one after another, and interleaved in batches. */
+    std::vector<int> tours((std::size_t) TOUR_POOL * n);
+    std::vector<int> batches(tours.size());
+    for (t = 0; t < TOUR_POOL; t++)
+    {
+        int *tour = tours.data() + (std::size_t) t * n;
+        std::iota(tour, tour + n, 0);
+        std::shuffle(tour, tour + n, gen);
+    }
+    for (t = 0; t < TOUR_POOL; t++)
+    {
+        int b = t / TOUR_BATCH, lane = t % TOUR_BATCH;
+        for (k = 0; k < n; k++)
+        {
+            batches[((std::size_t) b * n + k) * TOUR_BATCH + lane] =
+                tours[(std::size_t) t * n + k];
+        }
+    }
+
+    static const char *names[] = { "points", "matrix", "float", "dense" };
+    double checksum = 0.0, base = 0.0;
+
+    for (const char *name : names)
+    {
+        DistanceOptions opts;
+        parseDistanceKind(name, opts.kind);
+        std::unique_ptr<DistanceStore> dist = makeDistanceStore(opts, cloud);
+
+        double rate = toursPerSecond([&]() {
+            double sum = 0.0;
+            for (int s = 0; s < TOUR_POOL; s++)
+            {
+                sum += dist->tourLength(tours.data() + (std::size_t) s * n, n);
+            }
+            return sum;
+        }, TOUR_POOL, checksum);
+        if (base == 0.0)
+        {
+            base = rate;
+        }
+
+        std::cout << std::setw(7) << n << std::setw(9) << name
+            << std::setw(8) << "single" << std::setw(14) << rate
+            << std::setw(9) << rate / base << std::endl;
+    }
+
+    DistanceOptions opts;
+    opts.kind = DISTANCES_DENSE;
+    std::unique_ptr<DistanceStore> dense = makeDistanceStore(opts, cloud);
+    double rate = toursPerSecond([&]() {
+        double lengths[TOUR_BATCH], sum = 0.0;
+        for (int b = 0; b < TOUR_POOL / TOUR_BATCH; b++)
+        {
+            dense->tourLengths(batches.data() + (std::size_t) b * n * TOUR_BATCH,
+                n, lengths);
+            sum += lengths[0];
+        }
+        return sum;
+    }, TOUR_POOL, checksum);
+
+    std::cout << std::setw(7) << n << std::setw(9) << "dense"
+        << std::setw(8) << "batch" << std::setw(14) << rate
+        << std::setw(9) << rate / base;
+    if (!dense->batchesTours())
+    {
+        std::cout << "  (no vector kernel)";
+    }
+    std::cout << std::endl;
+
+    /* Keep the work observable. */
+    if (checksum < 0.0)
+    {
+        std::cout << checksum << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "size", required_argument, nullptr, 'n' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<int> sizes;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            sizes.push_back(atoi(optarg));
+            if (sizes.back() <= 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (sizes.empty())
+    {
+        sizes = { 10, 13, 50, 500, 5000 };
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << std::setw(7) << "n" << std::setw(9) << "store"
+        << std::setw(8) << "mode" << std::setw(14) << "tours/s"
+        << std::setw(9) << "vs pts" << std::endl;
+
+    for (int n : sizes)
+    {
+        benchmark(n);
+    }
+
+    return 0;
+}
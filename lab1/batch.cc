@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.hh"
+#include "heron.hh"
+
+// Size of the input and output buffers.
+#define BATCH_IO_BUFFER (1 << 20)
+
+
+// Collects output in one large buffer and hands it to stdio in big writes.
+class BufferedWriter {
+
+private:
+    FILE *out;
+    std::vector<char> buf;
+    std::size_t used;
+
+public:
+    BufferedWriter(FILE *out) : out(out), buf(BATCH_IO_BUFFER), used(0) {}
+    ~BufferedWriter() { flush(); }
+
+    void write(const char *data, std::size_t len) {
+        if (used + len > buf.size())
+        {
+            flush();
+        }
+        if (len > buf.size())
+        {
+            fwrite(data, 1, len, out);
+            return;
+        }
+        memcpy(buf.data() + used, data, len);
+        used += len;
+    }
+
+    void flush() {
+        fwrite(buf.data(), 1, used, out);
+        used = 0;
+    }
+};
+
+/*! Computes the areas of TRIS and formats one per line into TEXT, splitting the
+    triangles across up to NUM_THREADS threads.  Each thread formats into its
+    own string so the pieces can be written out in input order. */
+static void processBlock(const TriangleBatch &tris, std::vector<double> &areas,
+    std::vector<std::string> &text, int num_threads)
+{
+    std::vector<std::thread> workers;
+    std::size_t n = tris.size();
+    int t;
+
+    num_threads = std::max(1, std::min(num_threads,
+        (int) (n / BATCH_MIN_PER_THREAD)));
+    areas.resize(n);
+    text.resize(num_threads);
+
+    auto work = [&](int t) {
+        std::size_t begin = n * t / num_threads;
+        std::size_t end = n * (t + 1) / num_threads;
+        char line[32];
+        std::size_t i;
+
+        computeAreas(tris, begin, end, areas.data());
+
+        text[t].clear();
+        for (i = begin; i < end; i++)
+        {
+            int len = snprintf(line, sizeof(line), "%g\n", areas[i]);
+            text[t].append(line, len);
+        }
+    };
+
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(work, t));
+    }
+    work(0);
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+/*! Reads triangles (nine whitespace-separated coordinates each) from the file
+    at PATH, or from stdin if PATH is "-", and writes the area of each one to
+    stdout, one per line.  Input is read in BATCH_IO_BUFFER blocks and areas
+    are computed BATCH_TRIANGLES at a time on up to NUM_THREADS threads.
+
+    Reports throughput on stderr.  Returns 0 on success and 1 on bad input. */
+int runBatch(const char *path, int num_threads)
+{
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (in == nullptr)
+    {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    BufferedWriter writer(stdout);
+    TriangleBatch tris;
+    std::vector<double> areas;
+    std::vector<std::string> text;
+    std::vector<char> buf(BATCH_IO_BUFFER + 1);
+    double coords[9];
+    long long count = 0;
+    std::size_t carry = 0, got;
+    int ncoords = 0, t;
+    bool eof = false;
+
+    tris.reserve(BATCH_TRIANGLES);
+
+    while (!eof)
+    {
+        got = fread(buf.data() + carry, 1, BATCH_IO_BUFFER - carry, in);
+        eof = (got < BATCH_IO_BUFFER - carry);
+        std::size_t len = carry + got;
+        std::size_t end = len;
+
+        /* Unless this is the last block, leave any number cut off at the end
+           of the buffer for the next read. */
+        if (!eof)
+        {
+            while (end > 0 && !isspace((unsigned char) buf[end - 1]))
+            {
+                end--;
+            }
+            if (end == 0)
+            {
+                std::cerr << "Token too long in input" << std::endl;
+                return 1;
+            }
+        }
+
+        char saved = buf[end];
+        buf[end] = '\0';
+
+        char *p = buf.data();
+        while (true)
+        {
+            char *next;
+            double val = strtod(p, &next);
+
+            if (next == p)
+            {
+                /* Either the block is exhausted or the token is not a number. */
+                while (isspace((unsigned char) *p))
+                {
+                    p++;
+                }
+                if (*p != '\0')
+                {
+                    std::cerr << "Malformed coordinate in triangle "
+                        << count + tris.size() << std::endl;
+                    return 1;
+                }
+                break;
+            }
+
+            p = next;
+            coords[ncoords++] = val;
+            if (ncoords == 9)
+            {
+                tris.add(coords);
+                ncoords = 0;
+            }
+
+            if (tris.size() == BATCH_TRIANGLES)
+            {
+                processBlock(tris, areas, text, num_threads);
+                for (t = 0; t < (int) text.size(); t++)
+                {
+                    writer.write(text[t].data(), text[t].size());
+                }
+                count += tris.size();
+                tris.clear();
+            }
+        }
+
+        buf[end] = saved;
+        carry = len - end;
+        memmove(buf.data(), buf.data() + end, carry);
+    }
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    if (ncoords != 0)
+    {
+        std::cerr << "Incomplete triangle at end of input" << std::endl;
+        return 1;
+    }
+
+    processBlock(tris, areas, text, num_threads);
+    for (t = 0; t < (int) text.size(); t++)
+    {
+        writer.write(text[t].data(), text[t].size());
+    }
+    count += tris.size();
+    writer.flush();
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cerr << count << " triangles in " << elapsed.count() << " s ("
+        << count / std::max(elapsed.count(), 1e-9) << " triangles/s)"
+        << std::endl;
+
+    return 0;
+}
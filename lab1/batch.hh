@@ -0,0 +1,12 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+// Number of triangles parsed before a block is handed to the area kernel.
+#define BATCH_TRIANGLES (1 << 16)
+
+// Blocks with fewer triangles than this per thread are computed serially.
+#define BATCH_MIN_PER_THREAD 4096
+
+int runBatch(const char *path, int num_threads);
+
+#endif /* End of include guard for batch.hh */
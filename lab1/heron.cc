@@ -0,0 +1,139 @@
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "heron.hh"
+
+
+void TriangleBatch::clear()
+{
+    ax.clear(); ay.clear(); az.clear();
+    bx.clear(); by.clear(); bz.clear();
+    cx.clear(); cy.clear(); cz.clear();
+}
+
+void TriangleBatch::reserve(std::size_t n)
+{
+    ax.reserve(n); ay.reserve(n); az.reserve(n);
+    bx.reserve(n); by.reserve(n); bz.reserve(n);
+    cx.reserve(n); cy.reserve(n); cz.reserve(n);
+}
+
+/*! Appends the triangle whose vertices are COORDS[0..2], COORDS[3..5] and
+    COORDS[6..8]. */
+void TriangleBatch::add(const double coords[9])
+{
+    ax.push_back(coords[0]); ay.push_back(coords[1]); az.push_back(coords[2]);
+    bx.push_back(coords[3]); by.push_back(coords[4]); bz.push_back(coords[5]);
+    cx.push_back(coords[6]); cy.push_back(coords[7]); cz.push_back(coords[8]);
+}
+
+/*! Computes the areas of triangles [BEGIN, END) of TRIS into AREAS[BEGIN..END).
+
+    The same arithmetic as computeArea(), several triangles per instruction. */
+void computeAreas(const TriangleBatch &tris, std::size_t begin,
+    std::size_t end, double *areas)
+{
+    std::size_t i = begin;
+
+#if defined(__AVX__)
+    const __m256d half = _mm256_set1_pd(0.5);
+
+    for (; i + 4 <= end; i += 4)
+    {
+        __m256d ax = _mm256_loadu_pd(&tris.ax[i]);
+        __m256d ay = _mm256_loadu_pd(&tris.ay[i]);
+        __m256d az = _mm256_loadu_pd(&tris.az[i]);
+        __m256d bx = _mm256_loadu_pd(&tris.bx[i]);
+        __m256d by = _mm256_loadu_pd(&tris.by[i]);
+        __m256d bz = _mm256_loadu_pd(&tris.bz[i]);
+        __m256d cx = _mm256_loadu_pd(&tris.cx[i]);
+        __m256d cy = _mm256_loadu_pd(&tris.cy[i]);
+        __m256d cz = _mm256_loadu_pd(&tris.cz[i]);
+
+        /* Side lengths. */
+        __m256d dx = _mm256_sub_pd(ax, bx);
+        __m256d dy = _mm256_sub_pd(ay, by);
+        __m256d dz = _mm256_sub_pd(az, bz);
+        __m256d ab = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+            _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz))));
+        dx = _mm256_sub_pd(bx, cx);
+        dy = _mm256_sub_pd(by, cy);
+        dz = _mm256_sub_pd(bz, cz);
+        __m256d bc = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+            _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz))));
+        dx = _mm256_sub_pd(ax, cx);
+        dy = _mm256_sub_pd(ay, cy);
+        dz = _mm256_sub_pd(az, cz);
+        __m256d ac = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+            _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz))));
+
+        /* Semiperimeter and area. */
+        __m256d s = _mm256_mul_pd(_mm256_add_pd(ab, _mm256_add_pd(bc, ac)), half);
+        __m256d p = _mm256_mul_pd(_mm256_mul_pd(s, _mm256_sub_pd(s, ab)),
+            _mm256_mul_pd(_mm256_sub_pd(s, bc), _mm256_sub_pd(s, ac)));
+        _mm256_storeu_pd(areas + i, _mm256_sqrt_pd(p));
+    }
+#elif defined(__SSE2__)
+    const __m128d half = _mm_set1_pd(0.5);
+
+    for (; i + 2 <= end; i += 2)
+    {
+        __m128d ax = _mm_loadu_pd(&tris.ax[i]);
+        __m128d ay = _mm_loadu_pd(&tris.ay[i]);
+        __m128d az = _mm_loadu_pd(&tris.az[i]);
+        __m128d bx = _mm_loadu_pd(&tris.bx[i]);
+        __m128d by = _mm_loadu_pd(&tris.by[i]);
+        __m128d bz = _mm_loadu_pd(&tris.bz[i]);
+        __m128d cx = _mm_loadu_pd(&tris.cx[i]);
+        __m128d cy = _mm_loadu_pd(&tris.cy[i]);
+        __m128d cz = _mm_loadu_pd(&tris.cz[i]);
+
+        /* Side lengths. */
+        __m128d dx = _mm_sub_pd(ax, bx);
+        __m128d dy = _mm_sub_pd(ay, by);
+        __m128d dz = _mm_sub_pd(az, bz);
+        __m128d ab = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+            _mm_add_pd(_mm_mul_pd(dy, dy), _mm_mul_pd(dz, dz))));
+        dx = _mm_sub_pd(bx, cx);
+        dy = _mm_sub_pd(by, cy);
+        dz = _mm_sub_pd(bz, cz);
+        __m128d bc = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+            _mm_add_pd(_mm_mul_pd(dy, dy), _mm_mul_pd(dz, dz))));
+        dx = _mm_sub_pd(ax, cx);
+        dy = _mm_sub_pd(ay, cy);
+        dz = _mm_sub_pd(az, cz);
+        __m128d ac = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+            _mm_add_pd(_mm_mul_pd(dy, dy), _mm_mul_pd(dz, dz))));
+
+        /* Semiperimeter and area. */
+        __m128d s = _mm_mul_pd(_mm_add_pd(ab, _mm_add_pd(bc, ac)), half);
+        __m128d p = _mm_mul_pd(_mm_mul_pd(s, _mm_sub_pd(s, ab)),
+            _mm_mul_pd(_mm_sub_pd(s, bc), _mm_sub_pd(s, ac)));
+        _mm_storeu_pd(areas + i, _mm_sqrt_pd(p));
+    }
+#endif
+
+    /* Scalar tail (or everything when no vector unit is available). */
+    for (; i < end; i++)
+    {
+        double dx, dy, dz, ab, bc, ac;
+
+        dx = tris.ax[i] - tris.bx[i];
+        dy = tris.ay[i] - tris.by[i];
+        dz = tris.az[i] - tris.bz[i];
+        ab = sqrt(dx * dx + dy * dy + dz * dz);
+        dx = tris.bx[i] - tris.cx[i];
+        dy = tris.by[i] - tris.cy[i];
+        dz = tris.bz[i] - tris.cz[i];
+        bc = sqrt(dx * dx + dy * dy + dz * dz);
+        dx = tris.ax[i] - tris.cx[i];
+        dy = tris.ay[i] - tris.cy[i];
+        dz = tris.az[i] - tris.cz[i];
+        ac = sqrt(dx * dx + dy * dy + dz * dz);
+
+        areas[i] = heronArea(ab, bc, ac);
+    }
+}
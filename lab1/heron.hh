@@ -0,0 +1,32 @@
+#ifndef _HERON_H_
+#define _HERON_H_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*! Area of a triangle with side lengths AB, BC and AC (Heron's formula). */
+inline double heronArea(double ab, double bc, double ac)
+{
+    double s = (ab + bc + ac) / 2.0;
+    return sqrt(s * (s - ab) * (s - bc) * (s - ac));
+}
+
+// A block of triangles stored as structure-of-arrays: one array per
+// coordinate of each vertex, so batch kernels can load several triangles'
+// worth of the same coordinate at once.
+struct TriangleBatch {
+    std::vector<double> ax, ay, az;
+    std::vector<double> bx, by, bz;
+    std::vector<double> cx, cy, cz;
+
+    std::size_t size() const { return ax.size(); }
+    void clear();
+    void reserve(std::size_t n);
+    void add(const double coords[9]);
+};
+
+void computeAreas(const TriangleBatch &tris, std::size_t begin,
+    std::size_t end, double *areas);
+
+#endif /* End of include guard for heron.hh */
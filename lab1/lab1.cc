@@ -1,33 +1,90 @@
 #include <cmath>
+#include <cstdlib>
+#include <getopt.h>
+
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 #include "Point.hh"
+#include "batch.hh"
+#include "heron.hh"
 
 #define NUM_POINTS 3
 
+static void usage(const char *prog_name);
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options]" << std::endl
+        << "where options are" << std::endl
+        << "\t-b, --batch=FILE\tread triangles (nine coordinates each) from FILE, or stdin if FILE is -, and print one area per line" << std::endl
+        << "\t-t, --threads=N\tnumber of threads used in batch mode" << std::endl;
+    exit(1);
+}
+
 /*! Computes the area of the triangle specified by points a, b, and c using
     Heron's formula. */
 double computeArea(Point &a, Point &b, Point &c)
 {
-    double s, ab, bc, ac, area;
+    double ab, bc, ac;
 
     /* Compute the three side lengths in the triangle. */
     ab = a.distanceTo(b);
     bc = b.distanceTo(c);
     ac = a.distanceTo(c);
 
-    /* Compute the semiperimeter. */
-    s = (ab + bc + ac) / 2.0;
-
-    /* Compute the actual area. */
-    area = sqrt(s * (s - ab) * (s - bc) * (s - ac));
-
-    return area;
+    /* Compute the actual area from the semiperimeter. */
+    return heronArea(ab, bc, ac);
 }
 
-int main(int argc, char const *argv[])
+int main(int argc, char *argv[])
 {
     using namespace std;
+
+    static const struct option long_options[] = {
+        { "batch", required_argument, nullptr, 'b' },
+        { "threads", required_argument, nullptr, 't' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    const char *batch_path = nullptr;
+    int num_threads = max(1, (int) thread::hardware_concurrency());
+    int opt;
+
+    /* Read the options, checking that each is in-bounds. */
+    while ((opt = getopt_long(argc, argv, "b:t:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            batch_path = optarg;
+            break;
+
+        case 't':
+            num_threads = atoi(optarg);
+            if (num_threads <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    /* Batch mode streams many triangles without prompting. */
+    if (batch_path != nullptr)
+    {
+        return runBatch(batch_path, num_threads);
+    }
+
     int i;
     double x, y, z, area;
 
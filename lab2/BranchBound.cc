@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#include "BranchBound.hh"
+
+// A bound within this fraction of the shortest tour so far counts as
+// reaching it, so rounding in the bound cannot keep hopeless paths alive.
+// Tours that much shorter than the incumbent are not worth telling apart.
+#define BRANCH_BOUND_EPSILON 1e-9
+
+BranchBoundStats::BranchBoundStats()
+    : root_bound(0.0), initial_length(0.0), nodes(0), pruned(0), leaves(0),
+      tasks(0)
+{
+    // no-op
+}
+
+// Edge lengths of an instance, and the Lagrangian multipliers (one per
+// city) that tighten its bounds.  The bounds treat edges as undirected, so
+// on an asymmetric instance they take the cheaper direction of each:
+// reduced(i, j) = e(i, j) + pi[i] + pi[j].
+struct Instance {
+    int n;
+    bool symmetric;                     // c(i, j) == c(j, i) for all i, j
+    std::vector<double> cost;
+    std::vector<double> pi;
+    std::vector<double> reduced_cost;
+
+    double c(int i, int j) const { return cost[(std::size_t) i * n + j]; }
+    double e(int i, int j) const {
+        return symmetric ? c(i, j) : std::min(c(i, j), c(j, i));
+    }
+    double reduced(int i, int j) const {
+        return reduced_cost[(std::size_t) i * n + j];
+    }
+};
+
+// A subtree of the search: the path from city 0 that all its tours share.
+struct Task {
+    double bound;
+    double cost;
+    std::vector<int> path;
+};
+
+/*! Returns the length of the closed tour ORDER. */
+static double tourCost(const Instance &inst, const std::vector<int> &order)
+{
+    double length = 0.0;
+
+    for (int k = 0; k < inst.n; k++)
+    {
+        length += inst.c(order[k], order[(k + 1) % inst.n]);
+    }
+
+    return length;
+}
+
+/*! A starting tour: nearest neighbor from city 0, then 2-opt moves until
+    no pair of edges can be exchanged for a shorter pair.  A 2-opt move
+    reverses part of the tour, which changes the length of every edge in it
+    on an asymmetric instance, so those keep the nearest neighbor tour. */
+static std::vector<int> heuristicTour(const Instance &inst)
+{
+    int n = inst.n, i, j, k;
+    std::vector<int> tour(1, 0);
+    std::vector<char> used(n, 0);
+
+    used[0] = 1;
+    for (k = 1; k < n; k++)
+    {
+        int last = tour.back(), next = -1;
+        for (j = 0; j < n; j++)
+        {
+            if (!used[j] && (next < 0 || inst.c(last, j) < inst.c(last, next)))
+            {
+                next = j;
+            }
+        }
+        used[next] = 1;
+        tour.push_back(next);
+    }
+
+    /* Reversing tour[i + 1 .. j] replaces edges (a, b) and (c, d) with
+       (a, c) and (b, d); tour[0] never moves. */
+    bool improved = inst.symmetric;
+    while (improved)
+    {
+        improved = false;
+        for (i = 0; i < n - 2; i++)
+        {
+            for (j = i + 2; j < n; j++)
+            {
+                int a = tour[i], b = tour[i + 1];
+                int c = tour[j], d = tour[(j + 1) % n];
+                if (d == a)
+                {
+                    continue;
+                }
+                if (inst.c(a, c) + inst.c(b, d) < inst.c(a, b) + inst.c(c, d) - 1e-12)
+                {
+                    std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+    }
+
+    return tour;
+}
+
+/*! Computes a minimum 1-tree under the costs e(i, j) + PI[i] + PI[j]: a
+    spanning tree of cities 1 .. n - 1 plus the two cheapest edges at city
+    0.  Every tour is a 1-tree, so its weight minus 2 sum(PI) is a lower
+    bound on the optimum, which is returned.  DEGREE receives each city's
+    degree in the 1-tree. */
+static double oneTree(const Instance &inst, const std::vector<double> &pi,
+    std::vector<int> &degree)
+{
+    int n = inst.n, i, j;
+    std::vector<double> key(n, std::numeric_limits<double>::infinity());
+    std::vector<int> from(n, -1);
+    std::vector<char> in_tree(n, 0);
+    double weight = 0.0;
+
+    std::fill(degree.begin(), degree.end(), 0);
+
+    /* Prim's algorithm over cities 1 .. n - 1. */
+    key[1] = 0.0;
+    for (int added = 1; added < n; added++)
+    {
+        int u = -1;
+        for (i = 1; i < n; i++)
+        {
+            if (!in_tree[i] && (u < 0 || key[i] < key[u]))
+            {
+                u = i;
+            }
+        }
+        in_tree[u] = 1;
+        weight += key[u];
+        if (from[u] >= 0)
+        {
+            degree[u]++;
+            degree[from[u]]++;
+        }
+        for (j = 1; j < n; j++)
+        {
+            double w = inst.e(u, j) + pi[u] + pi[j];
+            if (!in_tree[j] && w < key[j])
+            {
+                key[j] = w;
+                from[j] = u;
+            }
+        }
+    }
+
+    /* The two cheapest edges at city 0. */
+    int first = -1, second = -1;
+    for (j = 1; j < n; j++)
+    {
+        double w = inst.e(0, j) + pi[j];
+        if (first < 0 || w < inst.e(0, first) + pi[first])
+        {
+            second = first;
+            first = j;
+        }
+        else if (second < 0 || w < inst.e(0, second) + pi[second])
+        {
+            second = j;
+        }
+    }
+    weight += inst.e(0, first) + inst.e(0, second)
+        + 2 * pi[0] + pi[first] + pi[second];
+    degree[0] = 2;
+    degree[first]++;
+    degree[second]++;
+
+    double pi_sum = 0.0;
+    for (i = 0; i < n; i++)
+    {
+        pi_sum += pi[i];
+    }
+
+    return weight - 2 * pi_sum;
+}
+
+/*! Raises the 1-tree bound by subgradient optimization (Held and Karp,
+    1971): cities of degree above 2 in the 1-tree are made more expensive
+    and leaves cheaper, with a step that shrinks whenever the bound stops
+    improving.  UPPER is the length of a known tour.  Stores the best
+    multipliers in INST and returns the bound they give. */
+static double optimizeMultipliers(Instance &inst, double upper)
+{
+    int n = inst.n, i, iter;
+    std::vector<double> pi(n, 0.0);
+    std::vector<int> degree(n);
+    double best = -std::numeric_limits<double>::infinity();
+    double step_scale = 2.0;
+    int stalled = 0, period = std::max(5, n / 2);
+
+    inst.pi = pi;
+    for (iter = 0; iter < 100 * n && step_scale > 1e-6; iter++)
+    {
+        double bound = oneTree(inst, pi, degree);
+        if (bound > best)
+        {
+            best = bound;
+            inst.pi = pi;
+            stalled = 0;
+        }
+        else if (++stalled >= period)
+        {
+            step_scale /= 2;
+            stalled = 0;
+        }
+
+        double norm = 0.0;
+        for (i = 0; i < n; i++)
+        {
+            norm += (degree[i] - 2) * (degree[i] - 2);
+        }
+        /* A 1-tree with all degrees 2 is a tour, hence optimal. */
+        if (norm == 0.0 || bound >= upper)
+        {
+            break;
+        }
+
+        double step = step_scale * (upper - bound) / norm;
+        for (i = 0; i < n; i++)
+        {
+            pi[i] += step * (degree[i] - 2);
+        }
+    }
+
+    inst.reduced_cost.resize((std::size_t) n * n);
+    for (i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            inst.reduced_cost[(std::size_t) i * n + j] = inst.e(i, j)
+                + inst.pi[i] + inst.pi[j];
+        }
+    }
+
+    return best;
+}
+
+// One thread's depth-first search, with its best tour and counters.
+struct Search {
+    const Instance *inst;
+    std::atomic<double> *incumbent;     // shortest tour length found so far
+    std::vector<int> path;
+    std::vector<char> visited;
+    std::vector<int> rest;              // scratch: cities left to visit
+    std::vector<double> key;            // scratch for Prim's algorithm
+
+    int task;                           // task being searched
+    double best_length;
+    int best_task;
+    std::vector<int> best_path;
+    long long nodes, pruned, leaves;
+
+    Search(const Instance &instance, std::atomic<double> &shortest);
+
+    bool reaches(double bound) const {
+        double limit = incumbent->load(std::memory_order_relaxed);
+        return bound >= limit - BRANCH_BOUND_EPSILON * limit;
+    }
+
+    double extensionBound(int depth, double cost, int v);
+    void search(int depth, double cost);
+};
+
+Search::Search(const Instance &instance, std::atomic<double> &shortest)
+    : inst(&instance), incumbent(&shortest), path(instance.n),
+      visited(instance.n), rest(instance.n), key(instance.n), task(-1),
+      best_length(std::numeric_limits<double>::infinity()), best_task(-1),
+      nodes(0), pruned(0), leaves(0)
+{
+    // no-op
+}
+
+/*! Lower bound on every tour that starts with PATH[0 .. DEPTH - 1] followed
+    by city V, where COST is the length of that path.
+
+    The rest of such a tour is a path from V through the set U of unvisited
+    cities back to 0: an edge from V into U, a spanning tree of U, and an
+    edge from U to 0.  Under the reduced costs each city of U has degree 2
+    on it and V and 0 have degree 1, so
+
+        rest >= min c'(V, U) + MST'(U) + min c'(U, 0)
+                - 2 sum(pi over U) - pi[V] - pi[0].
+
+    On a symmetric instance, tours that are mirror images of ones searched
+    elsewhere (last city below PATH[1]) get an infinite bound. */
+double Search::extensionBound(int depth, double cost, int v)
+{
+    const Instance &in = *inst;
+    int n = in.n, m = 0, i, j;
+    /* With FIRST = 0 every city may end the tour. */
+    int first = !in.symmetric ? 0 : depth >= 2 ? path[1] : v;
+    bool can_end = false;
+
+    for (i = 1; i < n; i++)
+    {
+        if (!visited[i] && i != v)
+        {
+            rest[m++] = i;
+            can_end = can_end || i > first;
+        }
+    }
+
+    if (m == 0)
+    {
+        return v < first ? std::numeric_limits<double>::infinity()
+            : cost + in.c(v, 0);
+    }
+    if (!can_end)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double into = std::numeric_limits<double>::infinity();
+    double back = std::numeric_limits<double>::infinity();
+    double pi_sum = 0.0;
+    for (i = 0; i < m; i++)
+    {
+        into = std::min(into, in.reduced(v, rest[i]));
+        back = std::min(back, in.reduced(rest[i], 0));
+        pi_sum += in.pi[rest[i]];
+        key[i] = in.reduced(rest[0], rest[i]);
+    }
+
+    /* Prim's algorithm over U; entries of REST before I are in the tree. */
+    double tree = 0.0;
+    for (i = 1; i < m; i++)
+    {
+        int closest = i;
+        for (j = i + 1; j < m; j++)
+        {
+            if (key[j] < key[closest])
+            {
+                closest = j;
+            }
+        }
+        std::swap(rest[i], rest[closest]);
+        std::swap(key[i], key[closest]);
+        tree += key[i];
+        for (j = i + 1; j < m; j++)
+        {
+            key[j] = std::min(key[j], in.reduced(rest[i], rest[j]));
+        }
+    }
+
+    return cost + into + tree + back - 2 * pi_sum - in.pi[v] - in.pi[0];
+}
+
+/*! Searches every completion of PATH[0 .. DEPTH - 1], whose length is COST.
+    Children whose bound reaches the incumbent are dropped; the rest are
+    searched in order of increasing bound. */
+void Search::search(int depth, double cost)
+{
+    const Instance &in = *inst;
+    int n = in.n, last = path[depth - 1], v;
+
+    if (depth == n)
+    {
+        double length = cost + in.c(last, 0);
+        leaves++;
+        if (length < best_length
+            && length < incumbent->load(std::memory_order_relaxed))
+        {
+            best_length = length;
+            best_task = task;
+            best_path = path;
+
+            double current = incumbent->load(std::memory_order_relaxed);
+            while (length < current && !incumbent->compare_exchange_weak(
+                current, length, std::memory_order_relaxed))
+            {
+                // no-op; CURRENT was reloaded
+            }
+        }
+        return;
+    }
+
+    std::vector<std::pair<double, int> > children;
+    for (v = 1; v < n; v++)
+    {
+        if (visited[v])
+        {
+            continue;
+        }
+
+        nodes++;
+        double bound = extensionBound(depth, cost + in.c(last, v), v);
+        if (reaches(bound))
+        {
+            pruned++;
+        }
+        else
+        {
+            children.push_back(std::make_pair(bound, v));
+        }
+    }
+
+    std::sort(children.begin(), children.end());
+    for (const std::pair<double, int> &child : children)
+    {
+        /* The incumbent may have improved since the bound was taken. */
+        if (reaches(child.first))
+        {
+            pruned++;
+            continue;
+        }
+
+        v = child.second;
+        visited[v] = 1;
+        path[depth] = v;
+        search(depth + 1, cost + in.c(last, v));
+        visited[v] = 0;
+    }
+}
+
+/*! Finds a shortest cycle by branch and bound.
+
+    The bounds come from the Held-Karp 1-tree relaxation: multipliers found
+    once at the root by subgradient optimization make the spanning trees in
+    Search::extensionBound() resemble paths.  The search starts from a
+    nearest neighbor tour improved by 2-opt.  The top levels of the tree are
+    expanded breadth first into tasks, which threads take in order of bound
+    and search depth first; a tour found by any thread immediately tightens
+    the pruning of all of them.  Like the other exact solvers, only one of
+    each tour and its reverse is considered if DIST is symmetric.
+
+    Complexity: O(n!) in the worst case; in practice the bounds cut the tree
+    to a small fraction of that. */
+std::vector<int> branchAndBoundShortestPath(const DistanceStore &dist,
+    int num_threads, BranchBoundStats *stats)
+{
+    Instance inst;
+    int n = dist.size(), i, j, t;
+
+    if (n <= 2 || (n == 3 && dist.symmetric()))
+    {
+        /* Every cycle through three or fewer cities has the same length. */
+        std::vector<int> order;
+        for (i = 0; i < n; i++)
+        {
+            order.push_back(i);
+        }
+        return order;
+    }
+
+    inst.n = n;
+    inst.symmetric = dist.symmetric();
+    inst.cost.resize((std::size_t) n * n);
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            inst.cost[(std::size_t) i * n + j] = dist.distance(i, j);
+        }
+    }
+
+    std::vector<int> best_tour = heuristicTour(inst);
+    double best_length = tourCost(inst, best_tour);
+    double root_bound = optimizeMultipliers(inst, best_length);
+    std::atomic<double> incumbent(best_length);
+
+    /* Expand the top of the tree breadth first until there is enough work
+       to share out. */
+    num_threads = std::max(1, num_threads);
+    Search top(inst, incumbent);
+    std::vector<Task> level(1);
+    int depth = 1;
+
+    level[0].bound = root_bound;
+    level[0].cost = 0.0;
+    level[0].path.assign(1, 0);
+    while ((int) level.size() < num_threads * BRANCH_BOUND_TASKS_PER_THREAD
+        && depth < n - 1 && !level.empty())
+    {
+        std::vector<Task> next;
+        for (const Task &task : level)
+        {
+            std::fill(top.visited.begin(), top.visited.end(), 0);
+            for (int c : task.path)
+            {
+                top.visited[c] = 1;
+            }
+            std::copy(task.path.begin(), task.path.end(), top.path.begin());
+
+            for (int v = 1; v < n; v++)
+            {
+                if (top.visited[v])
+                {
+                    continue;
+                }
+
+                Task child;
+                child.cost = task.cost + inst.c(task.path.back(), v);
+                child.bound = top.extensionBound(depth, child.cost, v);
+                top.nodes++;
+                if (top.reaches(child.bound))
+                {
+                    top.pruned++;
+                    continue;
+                }
+                child.path = task.path;
+                child.path.push_back(v);
+                next.push_back(child);
+            }
+        }
+        level.swap(next);
+        depth++;
+    }
+
+    std::sort(level.begin(), level.end(),
+        [](const Task &a, const Task &b) { return a.bound < b.bound; });
+
+    /* Search the tasks, most promising first. */
+    std::vector<Search> searches(std::min(num_threads,
+        std::max(1, (int) level.size())), Search(inst, incumbent));
+    std::vector<std::thread> workers;
+    std::atomic<int> next_task(0);
+
+    auto work = [&](int id) {
+        Search &s = searches[id];
+        int task;
+
+        while ((task = next_task++) < (int) level.size())
+        {
+            const Task &start = level[task];
+            if (s.reaches(start.bound))
+            {
+                s.pruned++;
+                continue;
+            }
+
+            s.task = task;
+            std::fill(s.visited.begin(), s.visited.end(), 0);
+            for (int k = 0; k < (int) start.path.size(); k++)
+            {
+                s.path[k] = start.path[k];
+                s.visited[start.path[k]] = 1;
+            }
+            s.search((int) start.path.size(), start.cost);
+        }
+    };
+
+    for (t = 1; t < (int) searches.size(); t++)
+    {
+        workers.push_back(std::thread(work, t));
+    }
+    work(0);
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+
+    /* Merge the threads' results; ties go to the earliest task so the
+       answer does not depend on scheduling. */
+    const Search *winner = nullptr;
+    for (const Search &s : searches)
+    {
+        if (s.best_task >= 0 && s.best_length < best_length
+            && (winner == nullptr || s.best_length < winner->best_length
+            || (s.best_length == winner->best_length
+            && s.best_task < winner->best_task)))
+        {
+            winner = &s;
+        }
+    }
+    if (winner != nullptr)
+    {
+        best_tour = winner->best_path;
+    }
+
+    if (stats != nullptr)
+    {
+        stats->root_bound = root_bound;
+        stats->initial_length = best_length;
+        stats->nodes = top.nodes;
+        stats->pruned = top.pruned;
+        stats->leaves = top.leaves;
+        stats->tasks = (int) level.size();
+        for (const Search &s : searches)
+        {
+            stats->nodes += s.nodes;
+            stats->pruned += s.pruned;
+            stats->leaves += s.leaves;
+        }
+    }
+
+    return best_tour;
+}
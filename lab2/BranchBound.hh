@@ -0,0 +1,31 @@
+#ifndef _BRANCH_BOUND_H_
+#define _BRANCH_BOUND_H_
+
+#include <vector>
+
+#include "DistanceStore.hh"
+
+// The search is split into at least this many subtrees per thread.
+#define BRANCH_BOUND_TASKS_PER_THREAD 16
+
+// Counters describing one branch-and-bound run.
+struct BranchBoundStats {
+    double root_bound;          // Lagrangian 1-tree bound on the optimum
+    double initial_length;      // length of the heuristic starting tour
+    long long nodes;            // partial tours whose bound was computed
+    long long pruned;           // partial tours discarded by their bound
+    long long leaves;           // complete tours measured
+    int tasks;                  // subtrees handed out to threads
+
+    BranchBoundStats();
+};
+
+// Finds a shortest Hamiltonian cycle through the cities of DIST by branch
+// and bound: paths from city 0 are extended one city at a time and dropped
+// as soon as a lower bound on their best completion reaches the shortest
+// tour found so far, which NUM_THREADS threads share.  If STATS is not null
+// it receives the search counters.
+std::vector<int> branchAndBoundShortestPath(const DistanceStore &dist,
+    int num_threads, BranchBoundStats *stats = nullptr);
+
+#endif /* End of include guard for BranchBound.hh */
@@ -0,0 +1,515 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#include "BruteForce.hh"
+
+// The best tour one thread has seen.
+struct LocalBest {
+    double length;
+    int task;                   // task that found it, to break ties
+    std::vector<int> path;
+};
+
+/*! Appends to PREFIXES every sequence of DEPTH distinct cities from
+    1 .. N - 1, in lexicographic order, extending the cities in CURRENT. */
+static void listPrefixes(int n, int depth, std::vector<int> &current,
+    std::vector<bool> &used, std::vector<int> &prefixes)
+{
+    if ((int) current.size() == depth)
+    {
+        prefixes.insert(prefixes.end(), current.begin(), current.end());
+        return;
+    }
+
+    for (int c = 1; c < n; c++)
+    {
+        if (!used[c])
+        {
+            used[c] = true;
+            current.push_back(c);
+            listPrefixes(n, depth, current, used, prefixes);
+            current.pop_back();
+            used[c] = false;
+        }
+    }
+}
+
+/*! Splits the tours through N > 3 cities among NUM_THREADS threads: fixes
+    enough leading cities after city 0 to give each thread several tasks,
+    always leaving at least one city free.  A RESUMABLE split depends only
+    on N instead.  Returns the number of fixed cities and stores the
+    prefixes, DEPTH cities per task, in PREFIXES. */
+static int makeTasks(int n, int num_threads, bool resumable,
+    std::vector<int> &prefixes)
+{
+    long long num_tasks = n - 1;
+    int depth = 1;
+
+    while (depth < n - 2 && (resumable
+        ? n - 1 - depth > BRUTE_FORCE_RESUMABLE_FREE_CITIES
+            && num_tasks * (n - 1 - depth) <= BRUTE_FORCE_RESUMABLE_MAX_TASKS
+        : num_tasks < (long long) num_threads * BRUTE_FORCE_TASKS_PER_THREAD))
+    {
+        num_tasks *= n - 1 - depth;
+        depth++;
+    }
+
+    std::vector<int> current;
+    std::vector<bool> used(n, false);
+    prefixes.clear();
+    listPrefixes(n, depth, current, used, prefixes);
+
+    return depth;
+}
+
+/*! Returns a lower bound on the tours of each task: the length of its path
+    from city 0 through its prefix, plus the shortest edge leaving the last
+    city of the prefix and each city not yet visited, since a tour leaves
+    each of them once more. */
+static std::vector<double> taskBounds(const DistanceStore &dist, int depth,
+    const std::vector<int> &prefixes)
+{
+    int n = dist.size(), num_tasks = (int) prefixes.size() / depth;
+    std::vector<double> shortest(n, std::numeric_limits<double>::infinity());
+    std::vector<double> bounds(num_tasks);
+    double all = 0.0;
+    int i, j, t, k;
+
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            if (j != i)
+            {
+                shortest[i] = std::min(shortest[i], dist.distance(i, j));
+            }
+        }
+        all += shortest[i];
+    }
+
+    for (t = 0; t < num_tasks; t++)
+    {
+        const int *prefix = prefixes.data() + (std::size_t) t * depth;
+        double bound = all - shortest[0];
+        int last = 0;
+
+        for (k = 0; k < depth; k++)
+        {
+            bound += dist.distance(last, prefix[k]);
+            if (k < depth - 1)
+            {
+                bound -= shortest[prefix[k]];
+            }
+            last = prefix[k];
+        }
+        bounds[t] = bound;
+    }
+
+    return bounds;
+}
+
+/*! Runs WORK(0) .. WORK(NUM_THREADS - 1) on that many threads, the first on
+    the calling thread, and then merges their results in BESTS.  Ties go to
+    the earliest task so the answer does not depend on scheduling.  Returns
+    an empty path if no thread found a tour. */
+template<class Work>
+static std::vector<int> runAndMerge(int num_threads, std::vector<LocalBest> &bests,
+    Work work)
+{
+    std::vector<std::thread> workers;
+    int t;
+
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(work, t));
+    }
+    work(0);
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+
+    const LocalBest *winner = nullptr;
+    for (t = 0; t < num_threads; t++)
+    {
+        const LocalBest &b = bests[t];
+        if (b.task >= 0 && (winner == nullptr || b.length < winner->length
+            || (b.length == winner->length && b.task < winner->task)))
+        {
+            winner = &b;
+        }
+    }
+
+    return winner != nullptr ? winner->path : std::vector<int>();
+}
+
+/*! Finds the shortest cycle by exhaustive search over (n - 1)! / 2 tours.
+
+    Every cycle is tried once: city 0 is always first, and if DIST is
+    symmetric, so that a tour and its reverse have the same length, only tours
+    whose second city is smaller than their last are evaluated.  Stores with a
+    batch kernel measure the tours TOUR_BATCH at a time with
+    DistanceStore::tourLengths().  The cities after 0 are split by their first
+    DEPTH cities into tasks that threads claim from a shared counter.  Each
+    thread keeps its own best tour, and the best of those is returned.  With
+    PROGRESS, each finished task and the thread's best tour so far are handed
+    to it; tasks it already holds are skipped, and no task is started once its
+    budget is spent.
+
+    Complexity: O(n!) where n is the number of points, divided among the
+    threads. */
+std::vector<int> parallelShortestPath(const DistanceStore &dist,
+    int num_threads, SearchProgress *progress)
+{
+    int n = dist.size(), i;
+    bool skip_mirrors = dist.symmetric();
+    std::vector<int> best_path;
+
+    if (n <= 2 || (n == 3 && skip_mirrors))
+    {
+        /* Every cycle through three or fewer cities has the same length. */
+        for (i = 0; i < n; i++)
+        {
+            best_path.push_back(i);
+        }
+        return best_path;
+    }
+
+    std::vector<int> prefixes;
+    num_threads = std::max(1, num_threads);
+    int depth = makeTasks(n, num_threads, progress != nullptr, prefixes);
+    int num_tasks = (int) prefixes.size() / depth;
+
+    if (progress != nullptr)
+    {
+        progress->begin(taskBounds(dist, depth, prefixes));
+    }
+
+    num_threads = std::min(num_threads, num_tasks);
+    std::vector<LocalBest> bests(num_threads);
+    std::atomic<int> next_task(0);
+
+    auto work = [&](int id) {
+        LocalBest &best = bests[id];
+        std::vector<int> path(n);
+        std::vector<bool> in_prefix(n);
+        std::vector<int> batch((std::size_t) n * TOUR_BATCH);
+        double lengths[TOUR_BATCH];
+        int task, k, filled = 0;
+        bool batched = dist.batchesTours();
+
+        best.length = std::numeric_limits<double>::infinity();
+        best.task = -1;
+
+        /* Measures the FILLED tours collected in BATCH together, padding
+           the batch with copies of the first. */
+        auto flush = [&]() {
+            int t;
+
+            for (t = filled; t < TOUR_BATCH; t++)
+            {
+                for (k = 0; k < n; k++)
+                {
+                    batch[k * TOUR_BATCH + t] = batch[k * TOUR_BATCH];
+                }
+            }
+            dist.tourLengths(batch.data(), n, lengths);
+
+            for (t = 0; t < filled; t++)
+            {
+                if (lengths[t] < best.length)
+                {
+                    best.length = lengths[t];
+                    best.task = task;
+                    for (k = 0; k < n; k++)
+                    {
+                        best.path[k] = batch[k * TOUR_BATCH + t];
+                    }
+                }
+            }
+            filled = 0;
+        };
+
+        best.path.resize(n);
+
+        while ((task = next_task++) < num_tasks)
+        {
+            const int *prefix = prefixes.data() + (std::size_t) task * depth;
+
+            if (progress != nullptr)
+            {
+                if (progress->isFinished(task))
+                {
+                    continue;
+                }
+                if (progress->timeIsUp())
+                {
+                    break;
+                }
+            }
+
+            /* Tour 0, the prefix, then the remaining cities in ascending
+               order, the first of their permutations. */
+            std::fill(in_prefix.begin(), in_prefix.end(), false);
+            path[0] = 0;
+            for (k = 0; k < depth; k++)
+            {
+                path[k + 1] = prefix[k];
+                in_prefix[prefix[k]] = true;
+            }
+            for (int c = 1, pos = depth + 1; c < n; c++)
+            {
+                if (!in_prefix[c])
+                {
+                    path[pos++] = c;
+                }
+            }
+
+            do
+            {
+                /* Skip the mirror image of a tour evaluated elsewhere. */
+                if (skip_mirrors && path[n - 1] < path[1])
+                {
+                    continue;
+                }
+
+                if (!batched)
+                {
+                    double length = dist.tourLength(path);
+                    if (length < best.length)
+                    {
+                        best.length = length;
+                        best.task = task;
+                        best.path = path;
+                    }
+                    continue;
+                }
+
+                for (k = 0; k < n; k++)
+                {
+                    batch[k * TOUR_BATCH + filled] = path[k];
+                }
+                if (++filled == TOUR_BATCH)
+                {
+                    flush();
+                }
+            } while (std::next_permutation(path.begin() + depth + 1, path.end()));
+
+            if (filled > 0)
+            {
+                flush();
+            }
+
+            if (progress != nullptr)
+            {
+                progress->finishTask(task, best.length, best.task, best.path);
+            }
+        }
+    };
+
+    best_path = runAndMerge(num_threads, bests, work);
+
+    return progress != nullptr ? progress->bestPath() : best_path;
+}
+
+// One thread's depth-first search through the tours of a task.
+struct DepthFirstSearch {
+    int n;
+    const std::vector<double> *d;           // n x n edge lengths
+    const std::vector<int> *nearest;        // row i: other cities, closest first
+    std::atomic<double> *shared_best;       // shortest tour length found so far
+    LocalBest *best;
+    int task;
+    bool skip_mirrors;                      // a tour and its reverse are equal
+    std::vector<int> path;
+    std::vector<char> visited;
+
+    void extend(int depth, double cost);
+};
+
+/*! Lowers the shared bound BOUND to LENGTH if that is shorter. */
+static void lowerBound(std::atomic<double> &bound, double length)
+{
+    double current = bound.load(std::memory_order_relaxed);
+
+    while (length < current
+        && !bound.compare_exchange_weak(current, length, std::memory_order_relaxed))
+    {
+        // no-op; CURRENT was reloaded
+    }
+}
+
+/*! Tries every way to complete PATH[0 .. DEPTH - 1], a path of length COST
+    from city 0.  The next city is chosen nearest first, so the first
+    candidate that would make the path as long as the best tour ends the
+    loop: every later candidate is at least as far. */
+void DepthFirstSearch::extend(int depth, double cost)
+{
+    int last = path[depth - 1];
+    const double *row = d->data() + (std::size_t) last * n;
+
+    if (depth == n)
+    {
+        /* Skip the mirror image of a tour evaluated elsewhere. */
+        if (skip_mirrors && last < path[1])
+        {
+            return;
+        }
+
+        double length = cost + row[0];
+        if (length < best->length
+            && length < shared_best->load(std::memory_order_relaxed))
+        {
+            best->length = length;
+            best->task = task;
+            best->path = path;
+            lowerBound(*shared_best, length);
+        }
+        return;
+    }
+
+    const int *next = nearest->data() + (std::size_t) last * (n - 1);
+    for (int k = 0; k < n - 1; k++)
+    {
+        int c = next[k];
+        if (visited[c])
+        {
+            continue;
+        }
+
+        double extended = cost + row[c];
+        if (extended >= shared_best->load(std::memory_order_relaxed))
+        {
+            break;
+        }
+
+        visited[c] = 1;
+        path[depth] = c;
+        extend(depth + 1, extended);
+        visited[c] = 0;
+    }
+}
+
+/*! Finds the shortest cycle by depth-first search over the same tours as
+    parallelShortestPath().  Each extension of a path adds one edge to its
+    running length instead of re-measuring the whole tour, and a path that
+    is already at least as long as the best tour found by any thread is
+    abandoned with everything below it.  PROGRESS is used as in
+    parallelShortestPath(), and the best tour it holds from an earlier run
+    prunes the search from the start.
+
+    Complexity: O(n!) in the worst case, usually far less. */
+std::vector<int> depthFirstShortestPath(const DistanceStore &dist,
+    int num_threads, SearchProgress *progress)
+{
+    int n = dist.size(), i, j;
+    std::vector<int> best_path;
+
+    if (n <= 2 || (n == 3 && dist.symmetric()))
+    {
+        /* Every cycle through three or fewer cities has the same length. */
+        for (i = 0; i < n; i++)
+        {
+            best_path.push_back(i);
+        }
+        return best_path;
+    }
+
+    /* A dense copy of the edge lengths, and each city's neighbors sorted by
+       distance. */
+    std::vector<double> d((std::size_t) n * n);
+    std::vector<int> nearest;
+    for (i = 0; i < n; i++)
+    {
+        std::vector<int> others;
+        for (j = 0; j < n; j++)
+        {
+            d[(std::size_t) i * n + j] = dist.distance(i, j);
+            if (j != i && j != 0)
+            {
+                others.push_back(j);
+            }
+        }
+        std::stable_sort(others.begin(), others.end(), [&](int a, int b) {
+            return d[(std::size_t) i * n + a] < d[(std::size_t) i * n + b];
+        });
+        /* City 0 is never a candidate; pad rows to n - 1 entries with it. */
+        others.push_back(0);
+        nearest.insert(nearest.end(), others.begin(), others.end());
+    }
+
+    std::vector<int> prefixes;
+    num_threads = std::max(1, num_threads);
+    int depth = makeTasks(n, num_threads, progress != nullptr, prefixes);
+    int num_tasks = (int) prefixes.size() / depth;
+
+    if (progress != nullptr)
+    {
+        progress->begin(taskBounds(dist, depth, prefixes));
+    }
+
+    num_threads = std::min(num_threads, num_tasks);
+    std::vector<LocalBest> bests(num_threads);
+    std::atomic<int> next_task(0);
+    std::atomic<double> shared_best(progress != nullptr ? progress->bestLength()
+        : std::numeric_limits<double>::infinity());
+
+    auto work = [&](int id) {
+        DepthFirstSearch search;
+        int task, k;
+
+        bests[id].length = std::numeric_limits<double>::infinity();
+        bests[id].task = -1;
+
+        search.n = n;
+        search.d = &d;
+        search.nearest = &nearest;
+        search.shared_best = &shared_best;
+        search.best = &bests[id];
+        search.skip_mirrors = dist.symmetric();
+        search.path.assign(n, 0);
+
+        while ((task = next_task++) < num_tasks)
+        {
+            const int *prefix = prefixes.data() + (std::size_t) task * depth;
+            double cost = 0.0;
+
+            if (progress != nullptr)
+            {
+                if (progress->isFinished(task))
+                {
+                    continue;
+                }
+                if (progress->timeIsUp())
+                {
+                    break;
+                }
+            }
+
+            search.task = task;
+            search.visited.assign(n, 0);
+            search.visited[0] = 1;
+            for (k = 0; k < depth; k++)
+            {
+                search.path[k + 1] = prefix[k];
+                search.visited[prefix[k]] = 1;
+                cost += d[(std::size_t) search.path[k] * n + prefix[k]];
+            }
+
+            search.extend(depth + 1, cost);
+
+            if (progress != nullptr)
+            {
+                const LocalBest &best = bests[id];
+                progress->finishTask(task, best.length, best.task, best.path);
+            }
+        }
+    };
+
+    best_path = runAndMerge(num_threads, bests, work);
+
+    return progress != nullptr ? progress->bestPath() : best_path;
+}
@@ -0,0 +1,39 @@
+#ifndef _BRUTE_FORCE_H_
+#define _BRUTE_FORCE_H_
+
+#include <vector>
+
+#include "DistanceStore.hh"
+#include "SearchProgress.hh"
+
+// The parallel search splits the tours into at least this many tasks per
+// thread, so that threads finishing early can take over remaining work.
+#define BRUTE_FORCE_TASKS_PER_THREAD 16
+
+// A search that reports its progress splits the tours by the number of cities
+// alone, so that a checkpoint can be resumed with any number of threads: into
+// tasks that leave at most this many cities free, so that the search can stop
+// soon after its time budget runs out, ...
+#define BRUTE_FORCE_RESUMABLE_FREE_CITIES 9
+
+// ... but never into more than this many tasks.
+#define BRUTE_FORCE_RESUMABLE_MAX_TASKS (1 << 22)
+
+// Finds a shortest Hamiltonian cycle through the cities of DIST by trying
+// every tour, like findShortestPath(), but only once per cycle: tours start
+// at city 0 and, if DIST is symmetric, of each tour and its reverse only one
+// is evaluated.  The tours are divided by prefix among NUM_THREADS threads.
+// If PROGRESS is not null the search resumes from it, records into it which
+// tasks are done, and stops early once its time budget runs out, returning
+// the best tour found.
+std::vector<int> parallelShortestPath(const DistanceStore &dist,
+    int num_threads, SearchProgress *progress = nullptr);
+
+// Finds a shortest cycle through the same tours as parallelShortestPath(),
+// but depth first: each path carries its running length, and paths already
+// as long as the best tour found so far are cut off.  PROGRESS is used as by
+// parallelShortestPath().
+std::vector<int> depthFirstShortestPath(const DistanceStore &dist,
+    int num_threads, SearchProgress *progress = nullptr);
+
+#endif /* End of include guard for BruteForce.hh */
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CostMatrixFile.hh"
+
+static_assert(sizeof(CostMatrixHeader) <= COST_MATRIX_DATA_OFFSET,
+    "the header must fit before the costs");
+
+// A cost matrix file mapped into memory, with costs of type T.
+template<class T>
+class MappedCostMatrix : public DistanceStore {
+
+private:
+    void *base;
+    std::size_t length;
+    int num_cities;
+    bool is_symmetric;
+    const T *costs;             // row-major, inside the mapping
+
+public:
+    MappedCostMatrix(void *base, std::size_t length, int num_cities,
+        bool is_symmetric);
+    ~MappedCostMatrix();
+
+    int size() const override;
+    double distance(int i, int j) const override;
+    double tourLength(const int *order, int n) const override;
+    std::size_t memoryBytes() const override;
+    bool symmetric() const override;
+};
+
+/*! Takes over the mapping of LENGTH bytes at BASE, a checked cost matrix
+    file of NUM_CITIES cities. */
+template<class T>
+MappedCostMatrix<T>::MappedCostMatrix(void *base, std::size_t length,
+    int num_cities, bool is_symmetric)
+    : base(base), length(length), num_cities(num_cities),
+      is_symmetric(is_symmetric),
+      costs((const T *) ((const char *) base + COST_MATRIX_DATA_OFFSET))
+{
+    // no-op
+}
+
+template<class T>
+MappedCostMatrix<T>::~MappedCostMatrix()
+{
+    munmap(base, length);
+}
+
+template<class T>
+int MappedCostMatrix<T>::size() const
+{
+    return num_cities;
+}
+
+template<class T>
+double MappedCostMatrix<T>::distance(int i, int j) const
+{
+    return costs[(std::size_t) i * num_cities + j];
+}
+
+/*! Walks the tour with direct lookups in the mapping.  Integer costs are
+    summed exactly in 64 bits, float costs in double precision. */
+template<class T>
+double MappedCostMatrix<T>::tourLength(const int *order, int n) const
+{
+    typedef typename std::conditional<std::is_integral<T>::value,
+        int64_t, double>::type Sum;
+    Sum sum = 0;
+    int k;
+
+    assert(n > 0);
+
+    for (k = 0; k < n - 1; k++)
+    {
+        sum += costs[(std::size_t) order[k] * num_cities + order[k + 1]];
+    }
+
+    return (double) (sum + costs[(std::size_t) order[n - 1] * num_cities + order[0]]);
+}
+
+/*! The whole mapping counts, though only pages touched are ever read. */
+template<class T>
+std::size_t MappedCostMatrix<T>::memoryBytes() const
+{
+    return length;
+}
+
+template<class T>
+bool MappedCostMatrix<T>::symmetric() const
+{
+    return is_symmetric;
+}
+
+/*! Parses a cost type given on the command line (float or int32) into
+    TYPE.  Returns false if NAME is not recognized. */
+bool parseCostType(const char *name, CostType &type)
+{
+    if (strcmp(name, "float") == 0)
+    {
+        type = COSTS_FLOAT32;
+    }
+    else if (strcmp(name, "int32") == 0)
+    {
+        type = COSTS_INT32;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*! Returns true if the file at PATH starts with the cost matrix magic.
+    Never true for stdin ("-"), which cannot be mapped. */
+bool isCostMatrixFile(const char *path)
+{
+    char magic[sizeof(COST_MATRIX_MAGIC)];
+    FILE *in;
+    bool match;
+
+    if (strcmp(path, "-") == 0 || (in = fopen(path, "rb")) == nullptr)
+    {
+        return false;
+    }
+
+    match = fread(magic, 1, sizeof(magic), in) == sizeof(magic)
+        && memcmp(magic, COST_MATRIX_MAGIC, sizeof(magic)) == 0;
+    fclose(in);
+
+    return match;
+}
+
+/*! Converts a cost to the 32-bit value stored for it. */
+static float storedFloat(double cost)
+{
+    return (float) cost;
+}
+
+static int32_t storedInt(double cost)
+{
+    return (int32_t) std::lround(cost);
+}
+
+/*! Returns true if the N x N row-major COSTS equal their transpose.  The
+    lower triangle is compared in 64 x 64 tiles, so the columns read
+    alongside each run of a row stay in cache. */
+template<class T>
+static bool isSymmetric(const T *costs, int n)
+{
+    const int TILE = 64;
+    int bi, bj, i, j;
+
+    for (bi = 0; bi < n; bi += TILE)
+    {
+        for (bj = 0; bj <= bi; bj += TILE)
+        {
+            for (i = bi; i < std::min(n, bi + TILE); i++)
+            {
+                for (j = bj; j < std::min(i, bj + TILE); j++)
+                {
+                    if (costs[(std::size_t) i * n + j]
+                        != costs[(std::size_t) j * n + i])
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/*! Writes the costs of DIST to PATH, one row at a time.  The header is
+    written last, once it is known whether the stored costs are symmetric.
+    Returns false and describes the problem in ERROR on failure. */
+bool writeCostMatrixFile(const char *path, const DistanceStore &dist,
+    CostType type, std::string &error)
+{
+    CostMatrixHeader header;
+    std::vector<char> pad(COST_MATRIX_DATA_OFFSET, 0);
+    int n = dist.size(), i, j;
+    bool symmetric = true;
+
+    FILE *out = fopen(path, "wb");
+    if (out == nullptr)
+    {
+        error = std::string("cannot create ") + path;
+        return false;
+    }
+
+    fwrite(pad.data(), 1, pad.size(), out);
+
+    if (type == COSTS_FLOAT32)
+    {
+        std::vector<float> row(n);
+        for (i = 0; i < n; i++)
+        {
+            for (j = 0; j < n; j++)
+            {
+                row[j] = storedFloat(dist.distance(i, j));
+                symmetric = symmetric && (j >= i
+                    || row[j] == storedFloat(dist.distance(j, i)));
+            }
+            fwrite(row.data(), sizeof(float), n, out);
+        }
+    }
+    else
+    {
+        std::vector<int32_t> row(n);
+        for (i = 0; i < n; i++)
+        {
+            for (j = 0; j < n; j++)
+            {
+                row[j] = storedInt(dist.distance(i, j));
+                symmetric = symmetric && (j >= i
+                    || row[j] == storedInt(dist.distance(j, i)));
+            }
+            fwrite(row.data(), sizeof(int32_t), n, out);
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COST_MATRIX_MAGIC, sizeof(COST_MATRIX_MAGIC));
+    header.type = type;
+    header.symmetric = symmetric;
+    header.count = n;
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+
+    if (ferror(out) | (fclose(out) != 0))
+    {
+        error = std::string("error writing ") + path;
+        return false;
+    }
+
+    return true;
+}
+
+/*! Maps the cost matrix file at PATH read-only and shared, checks its
+    header and wraps it in a store of the right cost type.  The solvers
+    skip mirrored tours when the costs are symmetric, which would make them
+    miss the optimum of an asymmetric matrix, so a header that claims
+    symmetry is checked against the costs.  Returns null and describes the
+    problem in ERROR if the file cannot be mapped or is malformed. */
+std::unique_ptr<DistanceStore> openCostMatrixFile(const char *path,
+    std::string &error)
+{
+    struct stat st;
+    void *base;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        error = std::string("cannot open ") + path;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return nullptr;
+    }
+
+    std::size_t length = st.st_size;
+    base = length > 0 ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        error = std::string("cannot map ") + path;
+        return nullptr;
+    }
+
+    const CostMatrixHeader *header = (const CostMatrixHeader *) base;
+    if (length < COST_MATRIX_DATA_OFFSET
+        || memcmp(header->magic, COST_MATRIX_MAGIC, sizeof(COST_MATRIX_MAGIC)) != 0)
+    {
+        munmap(base, length);
+        error = "not a cost matrix file";
+        return nullptr;
+    }
+
+    /* COUNT^2 costs of 4 bytes must fit, checked without overflowing. */
+    uint64_t count = header->count;
+    uint64_t entries = (length - COST_MATRIX_DATA_OFFSET) / 4;
+    if ((header->type != COSTS_FLOAT32 && header->type != COSTS_INT32)
+        || header->symmetric > 1 || count > (uint64_t) 0x7fffffff
+        || (count > 0 && entries / count < count))
+    {
+        munmap(base, length);
+        error = "corrupt cost matrix file header";
+        return nullptr;
+    }
+
+    if (count < 1)
+    {
+        munmap(base, length);
+        error = "cost matrix file has no cities";
+        return nullptr;
+    }
+
+    const char *data = (const char *) base + COST_MATRIX_DATA_OFFSET;
+    if (header->symmetric && (header->type == COSTS_FLOAT32
+        ? !isSymmetric((const float *) data, (int) count)
+        : !isSymmetric((const int32_t *) data, (int) count)))
+    {
+        munmap(base, length);
+        error = "cost matrix file is marked symmetric, but its costs are not";
+        return nullptr;
+    }
+
+    if (header->type == COSTS_FLOAT32)
+    {
+        return std::unique_ptr<DistanceStore>(new MappedCostMatrix<float>(
+            base, length, (int) count, header->symmetric));
+    }
+
+    return std::unique_ptr<DistanceStore>(new MappedCostMatrix<int32_t>(
+        base, length, (int) count, header->symmetric));
+}
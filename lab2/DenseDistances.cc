@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "DenseDistances.hh"
+
+/*! Computes the n x n table for CLOUD.  See assign(). */
+DenseDistances::DenseDistances(const PointCloud &cloud, int num_threads)
+    : num_points(0)
+{
+    assign(cloud, num_threads);
+}
+
+/*! Replaces the table with the n x n table for CLOUD, reusing the old
+    table's memory where it is large enough.  Rows are computed one at a
+    time with the cloud's one-to-many kernel, spread across NUM_THREADS
+    threads. */
+void DenseDistances::assign(const PointCloud &cloud, int num_threads)
+{
+    std::vector<std::thread> workers;
+    std::atomic<int> next_row(0);
+    int t;
+
+    num_points = cloud.size();
+    assert(num_points <= DENSE_MAX_CITIES);
+    table.resize((std::size_t) num_points * num_points);
+
+    auto work = [&]() {
+        std::vector<double> row(num_points);
+        int i;
+
+        while ((i = next_row++) < num_points)
+        {
+            cloud.distancesFrom(i, row.data());
+            std::copy(row.begin(), row.end(),
+                table.begin() + (std::size_t) i * num_points);
+        }
+    };
+
+    num_threads = std::max(1, std::min(num_threads, num_points));
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(work));
+    }
+    work();
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+int DenseDistances::size() const
+{
+    return num_points;
+}
+
+double DenseDistances::distance(int i, int j) const
+{
+    return table[(std::size_t) i * num_points + j];
+}
+
+/*! Walks the tour with direct table lookups, summing in double precision. */
+double DenseDistances::tourLength(const int *order, int n) const
+{
+    const float *d = table.data();
+    double dist = 0.0;
+    int k;
+
+    assert(n > 0);
+
+    for (k = 0; k < n - 1; k++)
+    {
+        dist += d[(std::size_t) order[k] * num_points + order[k + 1]];
+    }
+
+    return dist + d[(std::size_t) order[n - 1] * num_points + order[0]];
+}
+
+/*! Evaluates TOUR_BATCH tours at once.  With AVX2 the k-th edge of all
+    eight tours is fetched by one gather: the interleaved layout makes the
+    eight cities at position k (and at k + 1) one vector load each, and
+    their row * n + column offsets one multiply-add.  The sums are kept in
+    double precision, four lanes per register. */
+void DenseDistances::tourLengths(const int *orders, int n, double *lengths) const
+{
+    assert(n > 0);
+
+#if defined(__AVX2__)
+    static_assert(TOUR_BATCH == 8, "the AVX2 kernel handles eight tours");
+
+    const __m256i stride = _mm256_set1_epi32(num_points);
+    const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+    __m256i first = _mm256_loadu_si256((const __m256i *) orders);
+    __m256i prev = first;
+    int k;
+
+    for (k = 1; k <= n; k++)
+    {
+        __m256i cur = k < n
+            ? _mm256_loadu_si256((const __m256i *) (orders + k * TOUR_BATCH))
+            : first;
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(prev, stride), cur);
+        __m256 w = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), table.data(),
+            idx, all, 4);
+
+        lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(w)));
+        hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(w, 1)));
+        prev = cur;
+    }
+
+    _mm256_storeu_pd(lengths, lo);
+    _mm256_storeu_pd(lengths + 4, hi);
+#else
+    DistanceStore::tourLengths(orders, n, lengths);
+#endif
+}
+
+bool DenseDistances::batchesTours() const
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t DenseDistances::memoryBytes() const
+{
+    return table.size() * sizeof(float);
+}
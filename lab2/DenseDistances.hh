@@ -0,0 +1,39 @@
+#ifndef _DENSE_DISTANCES_H_
+#define _DENSE_DISTANCES_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+
+// Largest instance DenseDistances holds: n * n entries must fit the 32-bit
+// offsets of its gather instructions.
+#define DENSE_MAX_CITIES 46340
+
+// Full square table of single-precision distances, both triangles stored.
+// Twice the size of FloatDistanceMatrix, but entry (i, j) sits at i * n + j
+// with no branch on i < j, so a batch of tours can gather one edge from
+// each tour with a single vector instruction.  Cities are indexed with
+// 32-bit offsets, which limits the table to DENSE_MAX_CITIES cities.
+class DenseDistances : public DistanceStore {
+
+private:
+    int num_points;
+    std::vector<float, AlignedAllocator<float> > table;
+
+public:
+    DenseDistances(const PointCloud &cloud, int num_threads);
+
+    // Rebuilds the table for the points of CLOUD in the same storage.
+    void assign(const PointCloud &cloud, int num_threads);
+
+    int size() const override;
+    double distance(int i, int j) const override;
+    double tourLength(const int *order, int n) const override;
+    void tourLengths(const int *orders, int n, double *lengths) const override;
+    bool batchesTours() const override;
+    std::size_t memoryBytes() const override;
+};
+
+#endif /* End of include guard for DenseDistances.hh */
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include "HeldKarp.hh"
+
+// Subsets handed to a thread at a time while filling one layer.
+#define HELD_KARP_CHUNK 4096
+
+/*! Finds a shortest cycle with the Held-Karp recurrence.
+
+    City 0 is the fixed start; bit b of a subset S stands for city b + 1.
+    cost(S, j) is the length of the shortest path that leaves city 0, visits
+    exactly the cities of S and ends at j in S:
+
+        cost({j}, j) = d(0, j)
+        cost(S, j)   = min over k in S - {j} of cost(S - {j}, k) + d(k, j)
+
+    Only pairs with j in S are stored: the entries of S are packed together,
+    ordered by j, starting at offsets[S].  Every subset of size s depends
+    only on subsets of size s - 1, so each size is one layer whose subsets
+    are filled in parallel.
+
+    Complexity: O(n^2 2^n) time and O(n 2^n) space. */
+bool heldKarpShortestPath(const DistanceStore &dist, int num_threads,
+    std::vector<int> &order, std::string &error)
+{
+    int n = dist.size(), m = n - 1;
+    int i, j, t;
+
+    if (n > HELD_KARP_MAX_CITIES)
+    {
+        error = "Held-Karp handles at most " + std::to_string(HELD_KARP_MAX_CITIES)
+            + " cities (" + std::to_string(n) + " given)";
+        return false;
+    }
+
+    order.clear();
+    if (n <= 2 || (n == 3 && dist.symmetric()))
+    {
+        /* Every cycle through three or fewer cities has the same length. */
+        for (i = 0; i < n; i++)
+        {
+            order.push_back(i);
+        }
+        return true;
+    }
+
+    /* Single-precision copies of the edge lengths: from_start[j] = d(0, j + 1),
+       to_start[j] = d(j + 1, 0) and into[j * m + k] = d(k + 1, j + 1), so the
+       inner loop reads one row. */
+    std::vector<float> from_start(m), to_start(m), into((std::size_t) m * m);
+    for (j = 0; j < m; j++)
+    {
+        from_start[j] = (float) dist.distance(0, j + 1);
+        to_start[j] = (float) dist.distance(j + 1, 0);
+        for (int k = 0; k < m; k++)
+        {
+            into[(std::size_t) j * m + k] = (float) dist.distance(k + 1, j + 1);
+        }
+    }
+
+    uint32_t num_subsets = 1u << m;
+    std::vector<uint32_t> offsets(num_subsets);
+    uint32_t total = 0;
+    for (uint32_t s = 0; s < num_subsets; s++)
+    {
+        offsets[s] = total;
+        total += __builtin_popcount(s);
+    }
+
+    std::vector<float> cost(total);
+    std::vector<uint8_t> parent(total);
+
+    for (j = 0; j < m; j++)
+    {
+        cost[offsets[1u << j]] = from_start[j];
+    }
+
+    for (int size = 2; size <= m; size++)
+    {
+        std::vector<std::thread> workers;
+        std::atomic<uint32_t> next_chunk(0);
+        uint32_t num_chunks = (num_subsets + HELD_KARP_CHUNK - 1) / HELD_KARP_CHUNK;
+
+        auto work = [&]() {
+            uint32_t chunk;
+            int bits[32];
+
+            while ((chunk = next_chunk++) < num_chunks)
+            {
+                uint32_t end = std::min(num_subsets, (chunk + 1) * HELD_KARP_CHUNK);
+
+                for (uint32_t s = chunk * HELD_KARP_CHUNK; s < end; s++)
+                {
+                    if (__builtin_popcount(s) != size)
+                    {
+                        continue;
+                    }
+
+                    int count = 0;
+                    for (uint32_t rest = s; rest != 0; rest &= rest - 1)
+                    {
+                        bits[count++] = __builtin_ctz(rest);
+                    }
+
+                    float *out = cost.data() + offsets[s];
+                    uint8_t *out_parent = parent.data() + offsets[s];
+
+                    for (int rj = 0; rj < count; rj++)
+                    {
+                        int last = bits[rj];
+                        const float *prev = cost.data() + offsets[s ^ (1u << last)];
+                        const float *row = into.data() + (std::size_t) last * m;
+                        float best = std::numeric_limits<float>::infinity();
+                        int best_k = 0, r;
+
+                        /* In S - {last}, cities after LAST sit one entry
+                           earlier than they do in S. */
+                        for (r = 0; r < rj; r++)
+                        {
+                            float c = prev[r] + row[bits[r]];
+                            if (c < best)
+                            {
+                                best = c;
+                                best_k = bits[r];
+                            }
+                        }
+                        for (r = rj + 1; r < count; r++)
+                        {
+                            float c = prev[r - 1] + row[bits[r]];
+                            if (c < best)
+                            {
+                                best = c;
+                                best_k = bits[r];
+                            }
+                        }
+
+                        out[rj] = best;
+                        out_parent[rj] = (uint8_t) best_k;
+                    }
+                }
+            }
+        };
+
+        int layer_threads = std::max(1, std::min(num_threads, (int) num_chunks));
+        for (t = 1; t < layer_threads; t++)
+        {
+            workers.push_back(std::thread(work));
+        }
+        work();
+
+        for (t = 0; t < (int) workers.size(); t++)
+        {
+            workers[t].join();
+        }
+    }
+
+    /* Close the cycle from the best last city. */
+    uint32_t full = num_subsets - 1;
+    float best = std::numeric_limits<float>::infinity();
+    int last = 0;
+    for (j = 0; j < m; j++)
+    {
+        float c = cost[offsets[full] + j] + to_start[j];
+        if (c < best)
+        {
+            best = c;
+            last = j;
+        }
+    }
+
+    /* Walk the parents back to city 0, filling the order from the end. */
+    order.assign(n, 0);
+    uint32_t s = full;
+    for (i = n - 1; i >= 1; i--)
+    {
+        order[i] = last + 1;
+        int prev = parent[offsets[s] + __builtin_popcount(s & ((1u << last) - 1))];
+        s ^= 1u << last;
+        last = prev;
+    }
+
+    return true;
+}
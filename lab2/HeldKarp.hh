@@ -0,0 +1,20 @@
+#ifndef _HELD_KARP_H_
+#define _HELD_KARP_H_
+
+#include <string>
+#include <vector>
+
+#include "DistanceStore.hh"
+
+// Largest instance the Held-Karp solver accepts.  Its table holds
+// (n - 1) * 2^(n - 2) entries of five bytes, about 2 GB at this size.
+#define HELD_KARP_MAX_CITIES 26
+
+// Finds a shortest Hamiltonian cycle through the cities of DIST by dynamic
+// programming over subsets, spreading each subset-size layer across
+// NUM_THREADS threads.  Costs are accumulated in single precision.  Returns
+// false, with a message in ERROR, if the instance is too large.
+bool heldKarpShortestPath(const DistanceStore &dist, int num_threads,
+    std::vector<int> &order, std::string &error);
+
+#endif /* End of include guard for HeldKarp.hh */
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cassert>
+
+#include "LazyDistanceRows.hh"
+
+
+/*! Creates an empty row cache over CLOUD holding at most MAX_ROWS rows,
+    split evenly among the shards.  CLOUD must outlive this object. */
+LazyDistanceRows::LazyDistanceRows(const PointCloud &cloud, int max_rows)
+    : cloud(cloud), max_rows(std::max(1, std::min(max_rows, cloud.size()))),
+      num_shards(std::min(this->max_rows, LAZY_SHARDS)), shards(num_shards),
+      slot_of_row(cloud.size(), -1), misses(cloud.size(), 0)
+{
+    int s;
+
+    rows.resize((std::size_t) this->max_rows * cloud.size());
+    row_of_slot.assign(this->max_rows, -1);
+    last_use.assign(this->max_rows, 0);
+
+    for (s = 0; s < num_shards; s++)
+    {
+        shards[s].first_slot = this->max_rows * s / num_shards;
+        shards[s].num_slots = this->max_rows * (s + 1) / num_shards
+            - shards[s].first_slot;
+        shards[s].clock = 0;
+    }
+}
+
+/*! Computes row I into the least recently used slot of SHARD, the row's
+    shard, and returns the slot.  The caller must hold the shard's lock. */
+int LazyDistanceRows::loadRow(Shard &shard, int i) const
+{
+    int slot, s;
+
+    slot = shard.first_slot;
+    for (s = slot + 1; s < shard.first_slot + shard.num_slots; s++)
+    {
+        if (last_use[s] < last_use[slot])
+        {
+            slot = s;
+        }
+    }
+
+    if (row_of_slot[slot] >= 0)
+    {
+        slot_of_row[row_of_slot[slot]] = -1;
+        misses[row_of_slot[slot]] = 0;
+    }
+
+    cloud.distancesFrom(i, &rows[(std::size_t) slot * cloud.size()]);
+    row_of_slot[slot] = i;
+    slot_of_row[i] = slot;
+
+    return slot;
+}
+
+int LazyDistanceRows::size() const
+{
+    return cloud.size();
+}
+
+/*! Looks entry J of row I up in the cache and stores it in VALUE.  If the
+    row is not cached and COUNT_MISS is set, counts the miss, and on the
+    LAZY_ROW_MISSES-th one caches the row.  Returns false if VALUE was not
+    set. */
+bool LazyDistanceRows::lookup(int i, int j, bool count_miss,
+    double &value) const
+{
+    Shard &shard = shards[i % num_shards];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    int slot = slot_of_row[i];
+
+    if (slot < 0)
+    {
+        if (!count_miss || ++misses[i] < LAZY_ROW_MISSES)
+        {
+            return false;
+        }
+        slot = loadRow(shard, i);
+    }
+
+    last_use[slot] = ++shard.clock;
+    value = rows[(std::size_t) slot * cloud.size() + j];
+    return true;
+}
+
+/*! Looks the distance up in row J or row I if either is cached, and
+    computes the one entry otherwise, caching row I once it has missed
+    often enough.  Costs O(1) plus, now and then, a row. */
+double LazyDistanceRows::distance(int i, int j) const
+{
+    double value;
+
+    if (lookup(j, i, false, value) || lookup(i, j, true, value))
+    {
+        return value;
+    }
+
+    return cloud.distance(i, j);
+}
+
+/*! Evaluates a whole tour.  Each edge of a tour usually falls in a different
+    row, so filling rows here would cost O(n) per edge, and even reading the
+    cache would take a lock per edge; the cloud's tour kernel computes every
+    edge from the points instead, without touching the cache. */
+double LazyDistanceRows::tourLength(const int *order, int n) const
+{
+    assert(n > 0);
+
+    return cloud.tourLength(order, n);
+}
+
+std::size_t LazyDistanceRows::memoryBytes() const
+{
+    return rows.size() * sizeof(double);
+}
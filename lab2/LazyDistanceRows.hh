@@ -0,0 +1,61 @@
+#ifndef _LAZY_DISTANCE_ROWS_H_
+#define _LAZY_DISTANCE_ROWS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+
+// Lookups of a row that is not cached before it is computed and cached.
+#define LAZY_ROW_MISSES 16
+
+// Most shards the row cache is split into.
+#define LAZY_SHARDS 16
+
+// Distance store for instances too large for a full table.
+// Rows of the distance matrix are computed with the point cloud's
+// one-to-many kernel once they have been asked for LAZY_ROW_MISSES times,
+// and kept in a cache of at most max_rows rows; until then each lookup
+// computes just its one entry.  The cache is split into shards, row i
+// going to shard i % shards, each with its own lock and its own least
+// recently used eviction, so threads looking up different rows rarely
+// wait for each other.
+class LazyDistanceRows : public DistanceStore {
+
+private:
+    // The slots first_slot .. first_slot + num_slots - 1 and the rows that
+    // may occupy them.  LOCK guards their entries in the vectors below.
+    struct Shard {
+        std::mutex lock;
+        int first_slot;
+        int num_slots;
+        uint64_t clock;
+    };
+
+    const PointCloud &cloud;
+    int max_rows;
+    int num_shards;
+    mutable std::vector<Shard> shards;
+
+    mutable std::vector<double> rows;           // max_rows * size() entries
+    mutable std::vector<int> slot_of_row;       // -1 if the row is not cached
+    mutable std::vector<int> misses;            // lookups since it was last cached
+    mutable std::vector<int> row_of_slot;       // -1 if the slot is free
+    mutable std::vector<uint64_t> last_use;
+
+    bool lookup(int i, int j, bool count_miss, double &value) const;
+    int loadRow(Shard &shard, int i) const;
+
+public:
+    LazyDistanceRows(const PointCloud &cloud, int max_rows);
+
+    int size() const override;
+    double distance(int i, int j) const override;
+    double tourLength(const int *order, int n) const override;
+    std::size_t memoryBytes() const override;
+};
+
+#endif /* End of include guard for LazyDistanceRows.hh */
@@ -1,41 +1,115 @@
 #ifndef _POINT_H_
 #define _POINT_H_
 
+#include <array>
+#include <cmath>
 #include <iostream>
 
-// A 3-dimensional point class!
-// Coordinates are double-precision floating point.
-class Point {
+// A point in Dim-dimensional space with coordinates of type T.
+// Everything is inline and const-correct, so distance computations inline into
+// the solvers' loops; distanceTo() is a fixed-length loop the compiler can
+// unroll and vectorize.  Points of two or more dimensions are supported; the
+// x/y/z accessors name the first three coordinates.
+template<class T, int Dim>
+class BasicPoint {
+
+    static_assert(Dim >= 3, "planar points use the BasicPoint<T, 2> specialization");
 
 private:
-  double x_coord;
-  double y_coord;
-  double z_coord;
+    std::array<T, Dim> coords;
 
 public:
+    typedef T value_type;
+    static constexpr int dimension = Dim;
+
     // Constructors
-    Point();                      // default constructor
-    Point(double x, double y, double z);    // three-argument constructor
+    constexpr BasicPoint() : coords() {}
+    constexpr BasicPoint(T x, T y, T z) : coords{{ x, y, z }} {}
+
+    // Mutator methods
+    void setX(T val) { coords[0] = val; }
+    void setY(T val) { coords[1] = val; }
+    void setZ(T val) { coords[2] = val; }
+    void set(int i, T val) { coords[i] = val; }
+
+    // Accessor methods
+    constexpr T getX() const { return coords[0]; }
+    constexpr T getY() const { return coords[1]; }
+    constexpr T getZ() const { return coords[2]; }
+    constexpr T get(int i) const { return coords[i]; }
+
+    T squaredDistanceTo(const BasicPoint &p) const {
+        T sum = 0;
+        for (int i = 0; i < Dim; i++)
+        {
+            T d = p.coords[i] - coords[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    T distanceTo(const BasicPoint &p) const {
+        return std::sqrt(squaredDistanceTo(p));
+    }
+};
 
-    // Destructor
-    ~Point();
+// Planar points: only x and y are stored and z always reads as zero, so
+// z = 0 data takes two thirds of the memory and bandwidth of a 3D point.
+template<class T>
+class BasicPoint<T, 2> {
+
+private:
+    T x_coord;
+    T y_coord;
+
+public:
+    typedef T value_type;
+    static constexpr int dimension = 2;
+
+    // Constructors
+    constexpr BasicPoint() : x_coord(0), y_coord(0) {}
+    constexpr BasicPoint(T x, T y) : x_coord(x), y_coord(y) {}
 
     // Mutator methods
-    void setX(double val);
-    void setY(double val);
-    void setZ(double val);
+    void setX(T val) { x_coord = val; }
+    void setY(T val) { y_coord = val; }
+    void set(int i, T val) { (i == 0 ? x_coord : y_coord) = val; }
 
     // Accessor methods
-    double getX() const;
-    double getY() const;
-    double getZ() const;
+    constexpr T getX() const { return x_coord; }
+    constexpr T getY() const { return y_coord; }
+    constexpr T getZ() const { return 0; }
+    constexpr T get(int i) const { return i == 0 ? x_coord : y_coord; }
+
+    T squaredDistanceTo(const BasicPoint &p) const {
+        T dx = p.x_coord - x_coord;
+        T dy = p.y_coord - y_coord;
+        return dx * dx + dy * dy;
+    }
 
-    double distanceTo(const Point &p) const;
+    T distanceTo(const BasicPoint &p) const {
+        return std::sqrt(squaredDistanceTo(p));
+    }
 };
 
+// The original 3-dimensional double-precision point.
+typedef BasicPoint<double, 3> Point;
+
+// Planar and single-precision variants.  std::sqrt picks the float overload
+// for float coordinates, so float points compute distances in float.
+typedef BasicPoint<double, 2> Point2;
+typedef BasicPoint<float, 3> PointF;
+typedef BasicPoint<float, 2> Point2F;
+
 // Operator overload for convenience
-inline std::ostream& operator << (std::ostream &os, const Point &p) {
-    return os << "(" << p.getX() << ", " << p.getY() << ", " << p.getZ() << ")";
+template<class T, int Dim>
+inline std::ostream& operator << (std::ostream &os, const BasicPoint<T, Dim> &p) {
+    os << "(";
+    for (int i = 0; i < Dim; i++)
+    {
+        os << (i > 0 ? ", " : "") << p.get(i);
+    }
+    return os << ")";
 }
 
 #endif /* End of include guard for Point.hh */
@@ -0,0 +1,131 @@
+#ifndef _POINT_CLOUD_H_
+#define _POINT_CLOUD_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "Point.hh"
+
+// Alignment (in bytes) of the coordinate arrays; wide enough for AVX loads.
+#define POINT_CLOUD_ALIGN 32
+
+// Minimal allocator handing out POINT_CLOUD_ALIGN-aligned storage so the
+// coordinate arrays can be read with aligned vector loads.
+template<class T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() {}
+    template<class U> AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        void *p = nullptr;
+        if (posix_memalign(&p, POINT_CLOUD_ALIGN, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t) {
+        free(p);
+    }
+
+    template<class U> bool operator == (const AlignedAllocator<U> &) const {
+        return true;
+    }
+    template<class U> bool operator != (const AlignedAllocator<U> &) const {
+        return false;
+    }
+};
+
+typedef std::vector<double, AlignedAllocator<double> > CoordArray;
+
+// A structure-of-arrays container of 2- or 3-dimensional points.
+// The x, y and z coordinates live in separate aligned arrays so that distance
+// kernels can process several points per instruction.  Planar clouds (built
+// from BasicPoint<T, 2>) store no z array and their kernels skip it.
+//
+// A cloud either owns its arrays or is a view of arrays owned elsewhere, such
+// as a memory-mapped point file; copying a view copies only the pointers.
+class PointCloud {
+
+private:
+    int num_points;
+    int num_dims;
+    CoordArray x_coords;        // storage of an owning cloud
+    CoordArray y_coords;
+    CoordArray z_coords;
+    const double *x_ptr;        // the arrays actually read
+    const double *y_ptr;
+    const double *z_ptr;
+
+    void pointAtStorage();
+
+public:
+    // Constructors
+    PointCloud();
+    template<class T, int Dim>
+    PointCloud(const std::vector<BasicPoint<T, Dim> > &points);
+    PointCloud(const double *xs, const double *ys, const double *zs, int n);
+    PointCloud(const PointCloud &other);
+    PointCloud(PointCloud &&other) = default;
+
+    PointCloud &operator = (const PointCloud &other);
+    PointCloud &operator = (PointCloud &&other) = default;
+
+    // Accessors
+    int size() const { return num_points; }
+    int dims() const { return num_dims; }
+    double getX(int i) const { return x_ptr[i]; }
+    double getY(int i) const { return y_ptr[i]; }
+    double getZ(int i) const { return num_dims == 3 ? z_ptr[i] : 0.0; }
+    Point getPoint(int i) const;
+
+    // Coordinate arrays; zs() is null for planar clouds.
+    const double *xs() const { return x_ptr; }
+    const double *ys() const { return y_ptr; }
+    const double *zs() const { return z_ptr; }
+
+    // Distance between points i and j.
+    double distance(int i, int j) const {
+        double dx = x_ptr[i] - x_ptr[j];
+        double dy = y_ptr[i] - y_ptr[j];
+        double dz = num_dims == 3 ? z_ptr[i] - z_ptr[j] : 0.0;
+        return sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // Batch kernels
+    void distancesFrom(int i, double *out) const;
+    double tourLength(const int *order, int n) const;
+    double tourLength(const std::vector<int> &order) const {
+        return tourLength(order.data(), (int) order.size());
+    }
+};
+
+PointCloud buildPointCloud(const std::vector<Point> &points);
+
+/*! Constructs a point cloud holding a copy of POINTS, split into separate
+    coordinate arrays.  Points of more than three dimensions keep only x, y
+    and z. */
+template<class T, int Dim>
+PointCloud::PointCloud(const std::vector<BasicPoint<T, Dim> > &points)
+    : num_points((int) points.size()), num_dims(Dim == 2 ? 2 : 3),
+      x_coords(points.size()), y_coords(points.size()),
+      z_coords(Dim == 2 ? 0 : points.size())
+{
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        x_coords[i] = points[i].getX();
+        y_coords[i] = points[i].getY();
+        if (Dim != 2)
+        {
+            z_coords[i] = points[i].getZ();
+        }
+    }
+
+    pointAtStorage();
+}
+
+#endif /* End of include guard for PointCloud.hh */
@@ -0,0 +1,51 @@
+#ifndef _POINT_FILE_H_
+#define _POINT_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "PointCloud.hh"
+
+// Binary point files.
+//
+// Layout: a 32-byte PointFileHeader followed by the x, y and (for 3D files)
+// z coordinate arrays, each holding COUNT values of PRECISION bytes and each
+// starting on a POINT_CLOUD_ALIGN-byte boundary.  All fields are in host byte
+// order.  Because the arrays are already structure-of-arrays and aligned, a
+// double-precision file can be memory-mapped and used as a PointCloud without
+// copying.
+
+#define POINT_FILE_MAGIC "TSPPTS1"
+
+struct PointFileHeader {
+    char magic[8];              // POINT_FILE_MAGIC, NUL-terminated
+    uint32_t dims;              // 2 or 3
+    uint32_t precision;         // bytes per coordinate: 4 (float) or 8 (double)
+    uint64_t count;             // number of points
+    uint64_t reserved;          // zero
+};
+
+bool isPointFile(const char *path);
+bool writePointFile(const char *path, const PointCloud &cloud, int precision,
+    std::string &error);
+
+// A binary point file mapped into memory.  cloud() is a view of the mapping
+// for double-precision files; single-precision files are widened into a cloud
+// owned by this object.
+class MappedPointFile {
+
+private:
+    void *base;
+    std::size_t length;
+    PointCloud points;
+
+public:
+    MappedPointFile();
+    ~MappedPointFile();
+
+    bool open(const char *path, std::string &error);
+    const PointCloud &cloud() const { return points; }
+};
+
+#endif /* End of include guard for PointFile.hh */
@@ -0,0 +1,19 @@
+#ifndef _POINT_IO_H_
+#define _POINT_IO_H_
+
+#include <string>
+#include <vector>
+
+#include "Point.hh"
+
+// Inputs with fewer lines than this per thread are parsed serially.
+#define POINT_IO_MIN_LINES_PER_THREAD 16384
+
+bool readPoints(const char *path, std::vector<Point> &points, int num_threads,
+    std::string &error);
+bool parsePoints(const char *begin, const char *end, std::vector<Point> &points,
+    int num_threads, std::string &error);
+bool readInstances(const char *path, std::vector<std::vector<Point> > &instances,
+    std::string &error);
+
+#endif /* End of include guard for PointIO.hh */
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+
+#include "SearchProgress.hh"
+
+/*! Starts tracking a search named SOLVER over the cities of DIST.  The
+    fingerprint, a weighted sum of every edge length (in both directions if
+    they differ), ties a checkpoint to the instance and distance store it
+    was written for. */
+SearchProgress::SearchProgress(const std::string &solver,
+    const DistanceStore &dist)
+    : solver(solver), cities(dist.size()), fingerprint(0.0), num_tasks(-1),
+      num_finished(0), resumed(0),
+      best_length(std::numeric_limits<double>::infinity()), best_task(-1),
+      budget(0.0), report_interval(0.0), report(nullptr), stopped(false)
+{
+    int i, j;
+
+    assert(solver.size() < sizeof(CheckpointHeader().solver));
+
+    for (i = 0; i < cities; i++)
+    {
+        for (j = 0; j < i; j++)
+        {
+            fingerprint += (j + 1) * dist.distance(i, j);
+            if (!dist.symmetric())
+            {
+                fingerprint += (i + 1) * dist.distance(j, i);
+            }
+        }
+    }
+
+    start = last_report = last_save = std::chrono::steady_clock::now();
+}
+
+/*! Stops handing out tasks SECONDS after the search begins. */
+void SearchProgress::setBudget(double seconds)
+{
+    budget = seconds;
+}
+
+/*! Prints a progress line to OUT every SECONDS while the search runs. */
+void SearchProgress::setReports(std::ostream *out, double seconds)
+{
+    report = out;
+    report_interval = seconds;
+}
+
+/*! Saves checkpoints to PATH, first resuming from it if it exists.  Returns
+    false and describes the problem in ERROR if PATH cannot be read or holds
+    a checkpoint of some other search. */
+bool SearchProgress::setCheckpoint(const char *path, std::string &error)
+{
+    CheckpointHeader header;
+    FILE *in;
+
+    checkpoint = path;
+    if ((in = fopen(path, "rb")) == nullptr)
+    {
+        if (errno == ENOENT)
+        {
+            return true;
+        }
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+
+    bool ok = fread(&header, sizeof(header), 1, in) == 1
+        && memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0;
+    if (ok)
+    {
+        header.solver[sizeof(header.solver) - 1] = '\0';
+        if (solver != header.solver || (int) header.cities != cities
+            || header.fingerprint != fingerprint)
+        {
+            error = std::string(path) + " is a checkpoint of " + header.solver
+                + " over other cities or distances";
+            fclose(in);
+            return false;
+        }
+
+        best_task = header.best_task;
+        best_length = header.best_length;
+        if (best_task >= 0)
+        {
+            best_path.resize(cities);
+            ok = fread(best_path.data(), sizeof(int), cities, in)
+                == (std::size_t) cities;
+        }
+
+        num_tasks = header.tasks;
+        finished.resize((num_tasks + 7) / 8);
+        ok = ok && fread(finished.data(), 1, finished.size(), in)
+            == finished.size();
+    }
+    fclose(in);
+
+    if (!ok)
+    {
+        error = std::string(path) + " is not a complete checkpoint file";
+        return false;
+    }
+
+    return true;
+}
+
+/*! Called once by the search with a lower bound on the length of the tours
+    in each of its tasks.  Tasks finished by a resumed checkpoint are
+    skipped from here on. */
+void SearchProgress::begin(const std::vector<double> &task_bounds)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    long long t;
+
+    if (num_tasks < 0)
+    {
+        num_tasks = task_bounds.size();
+        finished.assign((num_tasks + 7) / 8, 0);
+    }
+    assert(num_tasks == (long long) task_bounds.size());
+    bounds = task_bounds;
+
+    num_finished = 0;
+    for (t = 0; t < num_tasks; t++)
+    {
+        num_finished += done(t);
+    }
+    resumed = num_finished;
+
+    start = last_report = last_save = std::chrono::steady_clock::now();
+}
+
+/*! Returns true if TASK was already searched, in this run or before. */
+bool SearchProgress::isFinished(int task) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    return done(task);
+}
+
+/*! Like isFinished(), for callers already holding the lock. */
+bool SearchProgress::done(long long task) const
+{
+    return (finished[task >> 3] >> (task & 7)) & 1;
+}
+
+/*! Returns true once the time budget has run out; from then on the search
+    should not start new tasks. */
+bool SearchProgress::timeIsUp()
+{
+    if (!stopped.load(std::memory_order_relaxed) && budget > 0.0
+        && elapsed() >= budget)
+    {
+        stopped = true;
+    }
+
+    return stopped.load(std::memory_order_relaxed);
+}
+
+/*! Marks TASK as searched.  LENGTH and PATH are the best tour the calling
+    thread has found so far, in task FOUND_BY, or FOUND_BY is negative if it
+    has found none.  Prints a progress report and saves a checkpoint when
+    they are due. */
+void SearchProgress::finishTask(int task, double length, int found_by,
+    const std::vector<int> &path)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    finished[task >> 3] |= 1 << (task & 7);
+    num_finished++;
+
+    if (found_by >= 0 && (length < best_length
+        || (length == best_length && found_by < best_task)))
+    {
+        best_length = length;
+        best_task = found_by;
+        best_path = path;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (report != nullptr && report_interval > 0.0
+        && std::chrono::duration<double>(now - last_report).count() >= report_interval)
+    {
+        printReport();
+        last_report = now;
+    }
+    if (!checkpoint.empty()
+        && std::chrono::duration<double>(now - last_save).count() >= SEARCH_CHECKPOINT_SECONDS)
+    {
+        /* A failed save is retried next time; save() reports the error. */
+        std::string error;
+        write(error);
+        last_save = now;
+    }
+}
+
+/*! Returns the fraction of the tasks, and so of the tours, searched. */
+double SearchProgress::coveredFraction() const
+{
+    return num_tasks > 0 ? (double) num_finished / num_tasks : 1.0;
+}
+
+/*! Returns a lower bound on the length of the shortest tour: the best tour
+    found, unless some unsearched task may still hold a shorter one. */
+double SearchProgress::lowerBound() const
+{
+    double bound = best_length;
+    long long t;
+
+    for (t = 0; t < num_tasks; t++)
+    {
+        if (!done(t))
+        {
+            bound = std::min(bound, bounds[t]);
+        }
+    }
+
+    return bound;
+}
+
+/*! Seconds since the search began. */
+double SearchProgress::elapsed() const
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Prints one line: time, coverage, best tour and lower bound. */
+void SearchProgress::printReport()
+{
+    std::ostream &out = *report;
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(1) << elapsed() << " s:\t"
+        << std::setprecision(2) << 100.0 * coveredFraction() << "% of "
+        << num_tasks << " tasks searched";
+    if (resumed > 0)
+    {
+        out << " (" << resumed << " before resuming)";
+    }
+    out << std::setprecision(6) << "\tbest tour:\t";
+    if (best_task >= 0)
+    {
+        out << best_length;
+    }
+    else
+    {
+        out << "none";
+    }
+    out << "\tlower bound:\t" << lowerBound() << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/*! Writes the checkpoint file, replacing the previous one only once the new
+    one is complete. */
+bool SearchProgress::write(std::string &error)
+{
+    CheckpointHeader header;
+    std::string temp = checkpoint + ".tmp";
+
+    FILE *out = fopen(temp.c_str(), "wb");
+    if (out == nullptr)
+    {
+        error = "cannot create " + temp;
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    memcpy(header.solver, solver.data(), solver.size());
+    header.cities = cities;
+    header.tasks = std::max(num_tasks, 0LL);
+    header.fingerprint = fingerprint;
+    header.best_length = best_length;
+    header.best_task = best_task;
+    fwrite(&header, sizeof(header), 1, out);
+
+    if (best_task >= 0)
+    {
+        fwrite(best_path.data(), sizeof(int), cities, out);
+    }
+    fwrite(finished.data(), 1, finished.size(), out);
+
+    if (ferror(out) | (fclose(out) != 0))
+    {
+        error = "error writing " + temp;
+        return false;
+    }
+    if (rename(temp.c_str(), checkpoint.c_str()) != 0)
+    {
+        error = "cannot replace " + checkpoint;
+        return false;
+    }
+
+    return true;
+}
+
+/*! Saves the checkpoint, if one was requested.  Returns false and describes
+    the problem in ERROR on failure. */
+bool SearchProgress::save(std::string &error)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (checkpoint.empty())
+    {
+        return true;
+    }
+
+    return write(error);
+}
+
+/*! Prints a final report, noting whether the search was cut short. */
+void SearchProgress::printSummary()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (report == nullptr)
+    {
+        return;
+    }
+
+    printReport();
+    if (!complete())
+    {
+        *report << "Time budget reached; the best tour is not proven shortest"
+            << (checkpoint.empty() ? "" : ", rerun with the same checkpoint to continue")
+            << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef _SEARCH_PROGRESS_H_
+#define _SEARCH_PROGRESS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "DistanceStore.hh"
+
+// Checkpoint files.
+//
+// Layout: a 56-byte CheckpointHeader, the CITIES cities of the best tour
+// found so far as 32-bit integers (only if the header's best_task is not
+// negative), and then a bitmap of the finished tasks, TASKS bits rounded up
+// to whole bytes, task t in bit t % 8 of byte t / 8.  All fields are in host
+// byte order.
+
+#define CHECKPOINT_MAGIC "TSPCKP1"
+
+struct CheckpointHeader {
+    char magic[8];              // CHECKPOINT_MAGIC, NUL-terminated
+    char solver[16];            // name of the search, NUL-padded
+    uint32_t cities;            // number of cities
+    uint32_t tasks;             // number of tasks the search is split into
+    double fingerprint;         // checksum of the edge lengths
+    double best_length;         // length of the best tour so far
+    int64_t best_task;          // task that found it, or -1 if none
+};
+
+// Seconds between checkpoint saves during a search.
+#define SEARCH_CHECKPOINT_SECONDS 10.0
+
+// The state of an exact search that is split into numbered tasks, each of
+// which is searched completely or not at all: which tasks are finished and
+// the best tour they found.  A search can be given a time budget, report its
+// progress periodically, and save its state to a checkpoint file from which
+// a later run of the same search over the same cities resumes.
+class SearchProgress {
+
+private:
+    std::string solver;
+    int cities;
+    double fingerprint;
+
+    std::vector<uint8_t> finished;      // bitmap of finished tasks
+    std::vector<double> bounds;         // lower bound on each task's tours
+    long long num_tasks;
+    long long num_finished;
+    long long resumed;                  // tasks finished by earlier runs
+
+    double best_length;
+    long long best_task;
+    std::vector<int> best_path;
+
+    double budget;
+    double report_interval;
+    std::ostream *report;
+    std::string checkpoint;
+
+    std::chrono::steady_clock::time_point start, last_report, last_save;
+    std::atomic<bool> stopped;
+    mutable std::mutex lock;
+
+    bool done(long long task) const;
+    double elapsed() const;
+    void printReport();
+    bool write(std::string &error);
+
+public:
+    SearchProgress(const std::string &solver, const DistanceStore &dist);
+
+    void setBudget(double seconds);
+    void setReports(std::ostream *out, double seconds);
+    bool setCheckpoint(const char *path, std::string &error);
+
+    // Called by the search.
+    void begin(const std::vector<double> &task_bounds);
+    bool isFinished(int task) const;
+    bool timeIsUp();
+    void finishTask(int task, double length, int found_by,
+        const std::vector<int> &path);
+
+    bool complete() const { return num_finished >= num_tasks; }
+    double coveredFraction() const;
+    double lowerBound() const;
+    double bestLength() const { return best_length; }
+    const std::vector<int> &bestPath() const { return best_path; }
+
+    bool save(std::string &error);
+    void printSummary();
+};
+
+#endif /* End of include guard for SearchProgress.hh */
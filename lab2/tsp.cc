@@ -1,63 +1,378 @@
 #include <cassert>
+#include <cstdlib>
+#include <getopt.h>
 
 #include <algorithm>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "BranchBound.hh"
+#include "BruteForce.hh"
+#include "CostMatrixFile.hh"
+#include "DistanceStore.hh"
+#include "HeldKarp.hh"
 #include "Point.hh"
+#include "PointCloud.hh"
+#include "PointFile.hh"
+#include "PointIO.hh"
+#include "SearchProgress.hh"
 #include "print_vector.h"
 
-double circuitLength(const std::vector<Point> &points, const std::vector<int> &order);
-std::vector<int> findShortestPath(const std::vector<Point> &points);
+// The exact solvers tsp can run.
+enum Algorithm {
+    ALGORITHM_BRUTE,            // try every permutation
+    ALGORITHM_PARALLEL,         // try every cycle once, on several threads
+    ALGORITHM_DFS,              // depth-first search with pruning
+    ALGORITHM_BRANCH_BOUND,     // depth-first search with 1-tree bounds
+    ALGORITHM_HELD_KARP         // dynamic programming over subsets
+};
 
-int main(int argc, char const *argv[])
+double circuitLength(const DistanceStore &dist, const std::vector<int> &order);
+std::vector<int> findShortestPath(const DistanceStore &dist);
+static bool parseAlgorithm(const char *name, Algorithm &algorithm);
+static void usage(const char *prog_name);
+
+/*! Parses a solver name given on the command line into ALGORITHM.  Returns
+    false if NAME is not recognized. */
+static bool parseAlgorithm(const char *name, Algorithm &algorithm)
+{
+    std::string s(name);
+
+    if (s == "brute")
+    {
+        algorithm = ALGORITHM_BRUTE;
+    }
+    else if (s == "parallel")
+    {
+        algorithm = ALGORITHM_PARALLEL;
+    }
+    else if (s == "dfs")
+    {
+        algorithm = ALGORITHM_DFS;
+    }
+    else if (s == "bnb")
+    {
+        algorithm = ALGORITHM_BRANCH_BOUND;
+    }
+    else if (s == "held-karp")
+    {
+        algorithm = ALGORITHM_HELD_KARP;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options]" << std::endl
+        << "where options are" << std::endl
+        << "\t-d, --distances=KIND\thow to look up distances: points (compute on demand), matrix (precomputed table of doubles), float (table of floats), int16 (table of 16-bit fixed-point values), lazy (rows computed on demand) or dense (full square table of floats, evaluated eight tours at a time)" << std::endl
+        << "\t-c, --cache-rows=N\tnumber of rows kept by the lazy distance store" << std::endl
+        << "\t-i, --input=FILE\tread the points from FILE (- for stdin) instead of prompting for them; FILE is either in the test-N.txt format or a binary point file, which is memory-mapped, or a binary cost matrix file, which is memory-mapped and used as the distances in place of -d" << std::endl
+        << "\t-t, --threads=N\tnumber of threads used to read input, build distance tables and solve" << std::endl
+        << "\t-a, --algorithm=NAME\texact solver: brute (try every permutation; the default), parallel (try each distinct cycle once, split across threads), dfs (like parallel, but extending paths one city at a time and abandoning those longer than the best tour so far), bnb (branch and bound with Lagrangian 1-tree bounds, for instances beyond held-karp) or held-karp (dynamic programming, up to " << HELD_KARP_MAX_CITIES << " cities)" << std::endl
+        << "\t-v, --verbose\treport search statistics of the bnb solver on stderr" << std::endl
+        << "\t-b, --budget=SECONDS\tstop the parallel or dfs solver after SECONDS and print the best tour found so far" << std::endl
+        << "\t-p, --progress=SECONDS\treport the parallel or dfs solver's coverage, best tour and lower bound on stderr every SECONDS" << std::endl
+        << "\t-k, --checkpoint=FILE\tresume the parallel or dfs solver from FILE if it exists, and save its progress there every " << SEARCH_CHECKPOINT_SECONDS << " seconds and on exit" << std::endl;
+    exit(1);
+}
+
+int main(int argc, char *argv[])
 {
     using namespace std;
 
-    int num_points, i;
-    double x, y, z;
+    static const struct option long_options[] = {
+        { "distances", required_argument, nullptr, 'd' },
+        { "cache-rows", required_argument, nullptr, 'c' },
+        { "input", required_argument, nullptr, 'i' },
+        { "threads", required_argument, nullptr, 't' },
+        { "algorithm", required_argument, nullptr, 'a' },
+        { "verbose", no_argument, nullptr, 'v' },
+        { "budget", required_argument, nullptr, 'b' },
+        { "progress", required_argument, nullptr, 'p' },
+        { "checkpoint", required_argument, nullptr, 'k' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    DistanceOptions distance_opts;
+    const char *input_path = nullptr;
+    Algorithm algorithm = ALGORITHM_BRUTE;
+    bool verbose = false;
+    double budget = 0.0, report_interval = 0.0;
+    const char *checkpoint_path = nullptr;
+    int opt;
+
+    /* Read the options, checking that each is in-bounds. */
+    while ((opt = getopt_long(argc, argv, "d:c:i:t:a:vb:p:k:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            if (!parseDistanceKind(optarg, distance_opts.kind))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'c':
+            distance_opts.cache_rows = atoi(optarg);
+            if (distance_opts.cache_rows <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'i':
+            input_path = optarg;
+            break;
+
+        case 't':
+            distance_opts.num_threads = atoi(optarg);
+            if (distance_opts.num_threads <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'a':
+            if (!parseAlgorithm(optarg, algorithm))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'v':
+            verbose = true;
+            break;
+
+        case 'b':
+            budget = atof(optarg);
+            if (budget <= 0.0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'p':
+            report_interval = atof(optarg);
+            if (report_interval <= 0.0)
+            {
+                usage(argv[0]);
+            }
+            break;
 
-    cout << "How many points?" << endl;
-    cin >> num_points;
+        case 'k':
+            checkpoint_path = optarg;
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    /* Only the solvers that split the tours into tasks can stop and resume. */
+    bool anytime = budget > 0.0 || report_interval > 0.0 || checkpoint_path != nullptr;
+    if (anytime && algorithm != ALGORITHM_PARALLEL && algorithm != ALGORITHM_DFS)
+    {
+        cerr << "--budget, --progress and --checkpoint need -a parallel or -a dfs" << endl;
+        return 1;
+    }
 
     std::vector<Point> pts;
+    MappedPointFile mapped;
+    PointCloud cloud;
+    unique_ptr<DistanceStore> dist;
+    bool from_matrix = input_path != nullptr && isCostMatrixFile(input_path);
+
+    if (from_matrix)
+    {
+        /* Look the costs up in the mapped matrix; there are no points. */
+        string error;
+        dist = openCostMatrixFile(input_path, error);
+        if (!dist)
+        {
+            cerr << input_path << ": " << error << endl;
+            return 1;
+        }
+    }
+    else if (input_path != nullptr && isPointFile(input_path))
+    {
+        /* Map a binary point file and use its coordinates in place. */
+        string error;
+        if (!mapped.open(input_path, error))
+        {
+            cerr << input_path << ": " << error << endl;
+            return 1;
+        }
+        cloud = mapped.cloud();
+    }
+    else
+    {
+        if (input_path != nullptr)
+        {
+            /* Bulk-load the text points without prompting. */
+            string error;
+            if (!readPoints(input_path, pts, distance_opts.num_threads, error))
+            {
+                cerr << input_path << ": " << error << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            /* Prompt user for the number of points. */
+            int num_points, i;
+            double x, y, z;
+
+            cout << "How many points?" << endl;
+            cin >> num_points;
+
+            /* Read in the specified number of points from STDIN. */
+            for (i = 0; i < num_points; i++)
+            {
+                cout << "Point " << i << ":" << endl;
+                cin >> x >> y >> z;
+                pts.push_back(Point(x, y, z));
+            }
+        }
 
-    /* Read in the specified number of points from STDIN. */
-    for (i = 0; i < num_points; i++)
+        cloud = buildPointCloud(pts);
+    }
+
+    /* Set up the requested distance lookup over the points. */
+    if (!dist)
     {
-        cout << "Point " << i << ":" << endl;
-        cin >> x >> y >> z;
-        pts.push_back(Point(x, y, z));
+        string error;
+        if (!checkDistanceKind(distance_opts.kind, cloud.size(), error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+        dist = makeDistanceStore(distance_opts, cloud);
     }
 
-    /* Compute the shortest path through the points and print it and its cost. */
-    std::vector<int> shortest_path = findShortestPath(pts);
-    cout << "Best order:\t" << shortest_path << endl;
-    cout << "Shortest distance:\t" << circuitLength(pts, shortest_path) << endl;
+    /* Compute the shortest path through the points and print it and its
+       exact cost: from the coordinates, or as given by a cost matrix. */
+    EuclideanDistances point_dist(cloud);
+    const DistanceStore &exact_dist = from_matrix ? *dist : point_dist;
+    std::vector<int> shortest_path;
+    unique_ptr<SearchProgress> progress;
 
-    return 0;
-}
+    if (anytime)
+    {
+        progress.reset(new SearchProgress(
+            algorithm == ALGORITHM_PARALLEL ? "parallel" : "dfs", *dist));
+        progress->setBudget(budget);
+        progress->setReports(&cerr, report_interval);
 
-/*! Returns the distance traveled in the points vector by traversing them in the
-    order specified by a given order vector. */
-double circuitLength(const std::vector<Point> &points, const std::vector<int> &order)
-{
-    int i;
-    double dist = 0.0;
+        string error;
+        if (checkpoint_path != nullptr
+            && !progress->setCheckpoint(checkpoint_path, error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
+    if (algorithm == ALGORITHM_HELD_KARP)
+    {
+        string error;
+        if (!heldKarpShortestPath(*dist, distance_opts.num_threads,
+            shortest_path, error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+    else if (algorithm == ALGORITHM_PARALLEL)
+    {
+        shortest_path = parallelShortestPath(*dist, distance_opts.num_threads,
+            progress.get());
+    }
+    else if (algorithm == ALGORITHM_DFS)
+    {
+        shortest_path = depthFirstShortestPath(*dist, distance_opts.num_threads,
+            progress.get());
+    }
+    else if (algorithm == ALGORITHM_BRANCH_BOUND)
+    {
+        BranchBoundStats stats;
+        shortest_path = branchAndBoundShortestPath(*dist,
+            distance_opts.num_threads, &stats);
 
-    assert(points.size() > 0);
+        if (verbose)
+        {
+            cerr << "Root bound:\t" << stats.root_bound
+                << "\tinitial tour:\t" << stats.initial_length << endl
+                << "Nodes:\t" << stats.nodes << "\tpruned:\t" << stats.pruned
+                << " (" << (stats.nodes > 0 ? 100.0 * stats.pruned / stats.nodes : 0.0)
+                << "%)\ttours:\t" << stats.leaves
+                << "\ttasks:\t" << stats.tasks << endl;
+        }
+    }
+    else
+    {
+        shortest_path = findShortestPath(*dist);
+    }
 
-    for (i = 0; i < order.size() - 1; i++)
+    if (progress)
     {
-        dist += points[order[i]].distanceTo(points[order[i+1]]);
+        progress->printSummary();
+
+        string error;
+        if (!progress->save(error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+        if (shortest_path.empty())
+        {
+            cerr << "No tour was completed within the budget" << endl;
+            return 1;
+        }
+    }
+
+    cout << "Best order:\t" << shortest_path << endl;
+    cout << "Shortest distance:\t" << circuitLength(exact_dist, shortest_path) << endl;
+
+    /* Lossy stores saw slightly different edge lengths; report by how much.
+       A tour of length 0 (one city, or all in one place) is stored
+       exactly. */
+    if (!from_matrix && isLossyDistanceKind(distance_opts.kind))
+    {
+        double exact = circuitLength(exact_dist, shortest_path);
+        double stored = circuitLength(*dist, shortest_path);
+        double relative = exact > 0.0 ? (stored - exact) / exact : 0.0;
+
+        cout << "Stored distance:\t" << stored << "\t(relative error "
+            << relative << ", " << dist->memoryBytes()
+            << " bytes)" << endl;
     }
 
-    dist += points[order[order.size() - 1]].distanceTo(points[order[0]]);
+    return 0;
+}
+
+/*! Returns the distance traveled through the cities of DIST by visiting them
+    in the order specified by a given order vector and returning to the start. */
+double circuitLength(const DistanceStore &dist, const std::vector<int> &order)
+{
+    assert(dist.size() > 0);
 
-    return dist;
+    return dist.tourLength(order);
 }
 
-/*! Finds the shortest Hamiltonian cycle in the passed vector of points.
+/*! Finds the shortest Hamiltonian cycle through the cities of DIST.
 
     Uses a naive algorithm that checks every possible path.
 
@@ -65,12 +380,12 @@ double circuitLength(const std::vector<Point> &points, const std::vector<int> &o
 
     Returns a vector containing the order to travel through points for the
     shortest path. */
-std::vector<int> findShortestPath(const std::vector<Point> &points)
+std::vector<int> findShortestPath(const DistanceStore &dist)
 {
     std::vector<int> best_path;
     double shortest_distance, cur_distance;
     int i;
-    std::vector<int> path(points.size());
+    std::vector<int> path(dist.size());
 
     /* Initial order of [0, 1, ... N - 1]. */
     for (i = 0; i < path.size(); i++)
@@ -79,13 +394,13 @@ std::vector<int> findShortestPath(const std::vector<Point> &points)
     }
 
     /* Seed the shortest distance and path variables. */
-    shortest_distance = circuitLength(points, path);
+    shortest_distance = circuitLength(dist, path);
     best_path = path;
 
     /* Loop through all permutations of the n points. */
     while (next_permutation(path.begin(), path.end()))
     {
-        cur_distance = circuitLength(points, path);
+        cur_distance = circuitLength(dist, path);
         // std::cout << path << "\t" << cur_distance << std::endl;
 
         /* If we found a shorter path, update the shortest distance and path. */
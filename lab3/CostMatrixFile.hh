@@ -0,0 +1,54 @@
+#ifndef _COST_MATRIX_FILE_H_
+#define _COST_MATRIX_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "DistanceStore.hh"
+
+// Binary cost matrix files.
+//
+// Layout: a 32-byte CostMatrixHeader, padding up to COST_MATRIX_DATA_OFFSET,
+// then the COUNT x COUNT costs in row-major order: the cost of travelling
+// from city i to city j is entry i * COUNT + j.  Costs are 32-bit floats or
+// 32-bit signed integers, in host byte order.  The matrix need not be
+// symmetric; solvers skip mirrored tours only if the header says it is,
+// and a file that says so is checked when it is opened.  Files are
+// memory-mapped read-only and shared, so any number of solver processes
+// reading the same file use one copy of it in the page cache, and apart
+// from that check nothing is read before it is first looked up.
+
+#define COST_MATRIX_MAGIC "TSPCST1"
+
+// Offset of the first cost, a whole cache line after the start of the file.
+#define COST_MATRIX_DATA_OFFSET 64
+
+// The types a cost matrix file can store.
+enum CostType {
+    COSTS_FLOAT32 = 1,
+    COSTS_INT32 = 2
+};
+
+struct CostMatrixHeader {
+    char magic[8];              // COST_MATRIX_MAGIC, NUL-terminated
+    uint32_t type;              // a CostType
+    uint32_t symmetric;         // 1 if entry (i, j) always equals (j, i)
+    uint64_t count;             // number of cities, at least 1
+    uint64_t reserved;          // zero
+};
+
+bool parseCostType(const char *name, CostType &type);
+bool isCostMatrixFile(const char *path);
+
+// Writes the costs of DIST to PATH as TYPE, rounding to the nearest integer
+// for COSTS_INT32.
+bool writeCostMatrixFile(const char *path, const DistanceStore &dist,
+    CostType type, std::string &error);
+
+// Maps the cost matrix file at PATH and returns a store that looks costs up
+// in the mapping, or null with the problem described in ERROR.
+std::unique_ptr<DistanceStore> openCostMatrixFile(const char *path,
+    std::string &error);
+
+#endif /* End of include guard for CostMatrixFile.hh */
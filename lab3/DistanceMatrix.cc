@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "DistanceMatrix.hh"
+
+
+/*! Returns an upper bound on the distance between any two points of CLOUD:
+    the diagonal of its bounding box. */
+static double boundingDiagonal(const PointCloud &cloud)
+{
+    double lo[3], hi[3], d2 = 0.0;
+    const double *coords[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+    int i, c;
+
+    for (c = 0; c < cloud.dims(); c++)
+    {
+        lo[c] = hi[c] = cloud.size() > 0 ? coords[c][0] : 0.0;
+        for (i = 1; i < cloud.size(); i++)
+        {
+            lo[c] = std::min(lo[c], coords[c][i]);
+            hi[c] = std::max(hi[c], coords[c][i]);
+        }
+        d2 += (hi[c] - lo[c]) * (hi[c] - lo[c]);
+    }
+
+    return sqrt(d2);
+}
+
+/*! Builds the distance table for every pair of points in CLOUD, splitting the
+    work across NUM_THREADS threads. */
+template<class T>
+BasicDistanceMatrix<T>::BasicDistanceMatrix(const PointCloud &cloud,
+    int num_threads)
+    : num_points(0), scale(1.0), inv_scale(1.0)
+{
+    assign(cloud, num_threads);
+}
+
+/*! Replaces the table with one for the points of CLOUD, reusing the memory
+    of the old table where it is large enough. */
+template<class T>
+void BasicDistanceMatrix<T>::assign(const PointCloud &cloud, int num_threads)
+{
+    num_points = cloud.size();
+    table.resize((std::size_t) num_points * (num_points - 1) / 2);
+
+    /* Fixed-point tables spread the instance's distance range over every
+       representable value of T. */
+    scale = inv_scale = 1.0;
+    if (std::is_integral<T>::value)
+    {
+        double diag = boundingDiagonal(cloud);
+        if (diag > 0.0)
+        {
+            scale = std::numeric_limits<T>::max() / diag;
+            inv_scale = 1.0 / scale;
+        }
+    }
+
+    buildTiles(cloud, num_threads);
+}
+
+/*! Fills the table in DISTANCE_MATRIX_TILE x DISTANCE_MATRIX_TILE tiles of the
+    lower triangle.  A tile touches only a small block of rows and columns of
+    the coordinate arrays, so both fit in cache while it is computed, and
+    distinct tiles write disjoint ranges of the table, so threads can claim
+    tiles from a shared counter without further locking. */
+template<class T>
+void BasicDistanceMatrix<T>::buildTiles(const PointCloud &cloud,
+    int num_threads)
+{
+    std::vector<std::pair<int, int> > tiles;
+    std::vector<std::thread> workers;
+    std::atomic<int> next_tile(0);
+    int ti, tj, t;
+
+    for (ti = 0; ti < num_points; ti += DISTANCE_MATRIX_TILE)
+    {
+        for (tj = 0; tj <= ti; tj += DISTANCE_MATRIX_TILE)
+        {
+            tiles.push_back(std::make_pair(ti, tj));
+        }
+    }
+
+    auto work = [&]() {
+        const double *xs = cloud.xs();
+        const double *ys = cloud.ys();
+        const double *zs = cloud.zs();
+        const bool planar = (cloud.dims() == 2);
+        const bool round = std::is_integral<T>::value;
+        int k;
+
+        while ((k = next_tile++) < (int) tiles.size())
+        {
+            int row_end = std::min(tiles[k].first + DISTANCE_MATRIX_TILE,
+                num_points);
+            int i, j;
+
+            for (i = tiles[k].first; i < row_end; i++)
+            {
+                /* Columns of this tile that lie strictly below the diagonal. */
+                int col_end = std::min(tiles[k].second + DISTANCE_MATRIX_TILE, i);
+                T *row = table.data() + index(i, 0);
+
+                for (j = tiles[k].second; j < col_end; j++)
+                {
+                    double dx = xs[i] - xs[j];
+                    double dy = ys[i] - ys[j];
+                    double dz = planar ? 0.0 : zs[i] - zs[j];
+                    double d = sqrt(dx * dx + dy * dy + dz * dz) * scale;
+                    row[j] = (T) (round ? d + 0.5 : d);
+                }
+            }
+        }
+    };
+
+    num_threads = std::max(1, std::min(num_threads, (int) tiles.size()));
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(work));
+    }
+    work();
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+template<class T>
+int BasicDistanceMatrix<T>::size() const
+{
+    return num_points;
+}
+
+template<class T>
+double BasicDistanceMatrix<T>::distance(int i, int j) const
+{
+    return at(i, j);
+}
+
+/*! Sums table lookups along the tour instead of recomputing square roots. */
+template<class T>
+double BasicDistanceMatrix<T>::tourLength(const int *order, int n) const
+{
+    int i;
+    double dist = 0.0;
+
+    assert(n > 0);
+
+    for (i = 0; i < n - 1; i++)
+    {
+        dist += at(order[i], order[i + 1]);
+    }
+
+    dist += at(order[n - 1], order[0]);
+
+    return dist;
+}
+
+template<class T>
+std::size_t BasicDistanceMatrix<T>::memoryBytes() const
+{
+    return table.size() * sizeof(T);
+}
+
+/* The element types the tsp programs can select. */
+template class BasicDistanceMatrix<double>;
+template class BasicDistanceMatrix<float>;
+template class BasicDistanceMatrix<uint16_t>;
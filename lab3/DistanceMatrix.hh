@@ -0,0 +1,58 @@
+#ifndef _DISTANCE_MATRIX_H_
+#define _DISTANCE_MATRIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+
+// Edge length (in rows/columns) of the square tiles the matrix is built in.
+#define DISTANCE_MATRIX_TILE 64
+
+// Precomputed table of all pairwise Euclidean distances.
+// Only the strictly lower triangle is stored, row by row, so an instance of
+// n cities takes n * (n - 1) / 2 entries of type T.  Floating-point T stores
+// distances directly; integral T stores them as fixed-point values scaled so
+// that the largest possible distance in the instance maps to T's maximum.
+template<class T>
+class BasicDistanceMatrix : public DistanceStore {
+
+private:
+    int num_points;
+    double scale;               // stored value = distance * scale
+    double inv_scale;
+    std::vector<T> table;
+
+    // Offset of entry (i, j), i > j, in the triangular table.
+    static std::size_t index(int i, int j) {
+        return (std::size_t) i * (i - 1) / 2 + j;
+    }
+
+    void buildTiles(const PointCloud &cloud, int num_threads);
+
+public:
+    BasicDistanceMatrix(const PointCloud &cloud, int num_threads);
+
+    // Rebuilds the table for the points of CLOUD in the same storage.
+    void assign(const PointCloud &cloud, int num_threads);
+
+    // Inline lookup for callers that know the concrete matrix type.
+    double at(int i, int j) const {
+        if (i == j)
+            return 0.0;
+        return (i > j ? table[index(i, j)] : table[index(j, i)]) * inv_scale;
+    }
+
+    int size() const override;
+    double distance(int i, int j) const override;
+    double tourLength(const int *order, int n) const override;
+    std::size_t memoryBytes() const override;
+};
+
+typedef BasicDistanceMatrix<double> DistanceMatrix;
+typedef BasicDistanceMatrix<float> FloatDistanceMatrix;
+typedef BasicDistanceMatrix<uint16_t> QuantizedDistanceMatrix;
+
+#endif /* End of include guard for DistanceMatrix.hh */
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+#include "DistanceStore.hh"
+#include "DenseDistances.hh"
+#include "DistanceMatrix.hh"
+#include "LazyDistanceRows.hh"
+
+
+DistanceStore::~DistanceStore()
+{
+    // no-op
+}
+
+/*! Default tour evaluation: one distance() lookup per edge. */
+double DistanceStore::tourLength(const int *order, int n) const
+{
+    int i;
+    double dist = 0.0;
+
+    assert(n > 0);
+
+    for (i = 0; i < n - 1; i++)
+    {
+        dist += distance(order[i], order[i + 1]);
+    }
+
+    dist += distance(order[n - 1], order[0]);
+
+    return dist;
+}
+
+/*! Default batch evaluation: each tour is copied out of the interleaved
+    batch, into a buffer kept per thread, and measured with tourLength(). */
+void DistanceStore::tourLengths(const int *orders, int n, double *lengths) const
+{
+    static thread_local std::vector<int> order;
+    int t, k;
+
+    order.resize(n);
+    for (t = 0; t < TOUR_BATCH; t++)
+    {
+        for (k = 0; k < n; k++)
+        {
+            order[k] = orders[k * TOUR_BATCH + t];
+        }
+        lengths[t] = tourLength(order.data(), n);
+    }
+}
+
+/*! The default tourLengths() only loops over tourLength(). */
+bool DistanceStore::batchesTours() const
+{
+    return false;
+}
+
+/*! Stores that only compute distances hold no distance data. */
+std::size_t DistanceStore::memoryBytes() const
+{
+    return 0;
+}
+
+/*! Distances between points are symmetric; only stores read from a cost
+    matrix may not be. */
+bool DistanceStore::symmetric() const
+{
+    return true;
+}
+
+/*! Wraps CLOUD, which must outlive this object. */
+EuclideanDistances::EuclideanDistances(const PointCloud &cloud) : cloud(cloud)
+{
+    // no-op
+}
+
+int EuclideanDistances::size() const
+{
+    return cloud.size();
+}
+
+double EuclideanDistances::distance(int i, int j) const
+{
+    return cloud.distance(i, j);
+}
+
+/*! Uses the point cloud's vectorized tour kernel. */
+double EuclideanDistances::tourLength(const int *order, int n) const
+{
+    return cloud.tourLength(order, n);
+}
+
+/*! Defaults: compute distances on demand, use every hardware thread for
+    precomputation and cache up to 1024 rows in lazy mode. */
+DistanceOptions::DistanceOptions()
+    : kind(DISTANCES_POINTS),
+      num_threads(std::max(1, (int) std::thread::hardware_concurrency())),
+      cache_rows(1024)
+{
+    // no-op
+}
+
+/*! Parses a distance store name given on the command line into KIND.
+
+    Returns false if NAME is not recognized. */
+bool parseDistanceKind(const char *name, DistanceKind &kind)
+{
+    if (strcmp(name, "points") == 0)
+    {
+        kind = DISTANCES_POINTS;
+    }
+    else if (strcmp(name, "matrix") == 0)
+    {
+        kind = DISTANCES_MATRIX;
+    }
+    else if (strcmp(name, "float") == 0)
+    {
+        kind = DISTANCES_FLOAT;
+    }
+    else if (strcmp(name, "int16") == 0)
+    {
+        kind = DISTANCES_INT16;
+    }
+    else if (strcmp(name, "lazy") == 0)
+    {
+        kind = DISTANCES_LAZY;
+    }
+    else if (strcmp(name, "dense") == 0)
+    {
+        kind = DISTANCES_DENSE;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*! Returns true if stores of the given KIND round distances, so tour lengths
+    reported by them differ from the exact Euclidean ones. */
+bool isLossyDistanceKind(DistanceKind kind)
+{
+    return kind == DISTANCES_FLOAT || kind == DISTANCES_INT16
+        || kind == DISTANCES_DENSE;
+}
+
+/*! Returns true if a store of the given KIND can hold NUM_POINTS cities;
+    otherwise sets ERROR to say why not and returns false. */
+bool checkDistanceKind(DistanceKind kind, int num_points, std::string &error)
+{
+    if (kind == DISTANCES_DENSE && num_points > DENSE_MAX_CITIES)
+    {
+        error = "the dense distance store handles at most "
+            + std::to_string(DENSE_MAX_CITIES) + " cities ("
+            + std::to_string(num_points) + " given)";
+        return false;
+    }
+
+    return true;
+}
+
+/*! Builds the distance store described by OPTS over CLOUD, whose size
+    checkDistanceKind() must accept.  CLOUD must outlive the returned
+    store. */
+std::unique_ptr<DistanceStore> makeDistanceStore(const DistanceOptions &opts,
+    const PointCloud &cloud)
+{
+    switch (opts.kind)
+    {
+    case DISTANCES_MATRIX:
+        return std::unique_ptr<DistanceStore>(
+            new DistanceMatrix(cloud, opts.num_threads));
+
+    case DISTANCES_FLOAT:
+        return std::unique_ptr<DistanceStore>(
+            new FloatDistanceMatrix(cloud, opts.num_threads));
+
+    case DISTANCES_INT16:
+        return std::unique_ptr<DistanceStore>(
+            new QuantizedDistanceMatrix(cloud, opts.num_threads));
+
+    case DISTANCES_LAZY:
+        return std::unique_ptr<DistanceStore>(
+            new LazyDistanceRows(cloud, opts.cache_rows));
+
+    case DISTANCES_DENSE:
+        return std::unique_ptr<DistanceStore>(
+            new DenseDistances(cloud, opts.num_threads));
+
+    case DISTANCES_POINTS:
+    default:
+        return std::unique_ptr<DistanceStore>(new EuclideanDistances(cloud));
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef _DISTANCE_STORE_H_
+#define _DISTANCE_STORE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PointCloud.hh"
+
+// Number of tours evaluated together by DistanceStore::tourLengths().
+#define TOUR_BATCH 8
+
+// Abstract lookup interface for the pairwise costs of a TSP instance.
+// Solvers only ever ask a DistanceStore for distances, so the same solver can
+// run on coordinates, a precomputed table, or any other cost source.
+class DistanceStore {
+
+public:
+    virtual ~DistanceStore();
+
+    // Number of cities.
+    virtual int size() const = 0;
+
+    // Cost of travelling from city i to city j.
+    virtual double distance(int i, int j) const = 0;
+
+    // Length of the closed tour visiting the N cities named by ORDER.
+    virtual double tourLength(const int *order, int n) const;
+    double tourLength(const std::vector<int> &order) const {
+        return tourLength(order.data(), (int) order.size());
+    }
+
+    // Lengths of TOUR_BATCH closed tours of N cities each, stored
+    // interleaved: ORDERS[k * TOUR_BATCH + t] is the k-th city of tour t,
+    // whose length goes to LENGTHS[t].
+    virtual void tourLengths(const int *orders, int n, double *lengths) const;
+
+    // True if tourLengths() is faster than TOUR_BATCH tourLength() calls,
+    // so callers should gather tours into batches.
+    virtual bool batchesTours() const;
+
+    // Bytes of distance data held by the store.
+    virtual std::size_t memoryBytes() const;
+
+    // True if distance(i, j) == distance(j, i) for all cities, so a tour
+    // and its reverse have the same length.
+    virtual bool symmetric() const;
+};
+
+// Computes Euclidean distances on demand from a point cloud.
+class EuclideanDistances : public DistanceStore {
+
+private:
+    const PointCloud &cloud;
+
+public:
+    EuclideanDistances(const PointCloud &cloud);
+
+    int size() const override;
+    double distance(int i, int j) const override;
+    double tourLength(const int *order, int n) const override;
+};
+
+// The ways a DistanceStore can be built from coordinates.
+enum DistanceKind {
+    DISTANCES_POINTS,           // compute from coordinates on every lookup
+    DISTANCES_MATRIX,           // precomputed triangular double matrix
+    DISTANCES_FLOAT,            // precomputed triangular float matrix
+    DISTANCES_INT16,            // precomputed 16-bit fixed-point matrix
+    DISTANCES_LAZY,             // rows computed on demand, bounded row cache
+    DISTANCES_DENSE             // full square float matrix, batch kernel
+};
+
+// Settings for building a DistanceStore from the command line.
+struct DistanceOptions {
+    DistanceKind kind;
+    int num_threads;            // threads used to precompute tables
+    int cache_rows;             // row cache size for DISTANCES_LAZY
+
+    DistanceOptions();
+};
+
+bool parseDistanceKind(const char *name, DistanceKind &kind);
+bool isLossyDistanceKind(DistanceKind kind);
+bool checkDistanceKind(DistanceKind kind, int num_points, std::string &error);
+std::unique_ptr<DistanceStore> makeDistanceStore(const DistanceOptions &opts,
+    const PointCloud &cloud);
+
+#endif /* End of include guard for DistanceStore.hh */
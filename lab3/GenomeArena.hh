@@ -0,0 +1,124 @@
+#ifndef _GENOME_ARENA_H_
+#define _GENOME_ARENA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bytes each tour in a GenomeArena is aligned to: one cache line.
+#define ARENA_ALIGNMENT 64
+
+// A view of COUNT consecutive city indices owned by someone else, such as
+// one tour in a GenomeArena.  Copying a TourSpan copies two words, never
+// the cities; TourSpan<const Index> is the read-only view.
+template<class Index>
+class TourSpan {
+
+private:
+    Index *first;
+    int count;
+
+public:
+    TourSpan(Index *first, int count) : first(first), count(count) {}
+
+    // A read-only view of a writable span.
+    template<class Other>
+    TourSpan(const TourSpan<Other> &other)
+        : first(other.data()), count(other.size()) {}
+
+    int size() const { return count; }
+    Index *data() const { return first; }
+    Index *begin() const { return first; }
+    Index *end() const { return first + count; }
+    Index &operator[](int k) const { return first[k]; }
+};
+
+// The tours of a whole population of the genetic algorithm in one block of
+// memory: genome g's cities start at g * stride(), along with its circuit
+// length and whether that length is out of date.  INDEX is the type of a
+// city number, uint16_t for instances of up to 65536 cities, halving the
+// bytes every crossover and evaluation moves, or uint32_t beyond.  The
+// stride is rounded up to whole cache lines and the block aligned to one,
+// so threads writing neighbouring genomes never share a line.  reset()
+// keeps the block when it is already large enough, so an arena reused from
+// generation to generation, or from run to run, allocates nothing.
+template<class Index>
+class GenomeArena {
+
+private:
+    int num_genomes;
+    int num_cities;
+    int stride_;
+    std::vector<Index> storage;         // the tours, plus room to align them
+    Index *base;                        // genome 0, aligned
+    std::vector<double> lengths;
+    std::vector<unsigned char> dirty;
+
+public:
+    GenomeArena() : num_genomes(0), num_cities(0), stride_(0), base(nullptr) {}
+
+    // Not copyable, since BASE points into STORAGE.
+    GenomeArena(const GenomeArena &) = delete;
+    GenomeArena &operator=(const GenomeArena &) = delete;
+
+    // Makes room for NUM_GENOMES tours of NUM_CITIES cities each.  Their
+    // contents are undefined and every genome is dirty.
+    void reset(int num_genomes, int num_cities);
+
+    int size() const { return num_genomes; }
+    int cities() const { return num_cities; }
+    int stride() const { return stride_; }
+
+    TourSpan<Index> tour(int g) {
+        return TourSpan<Index>(base + (std::size_t) g * stride_, num_cities);
+    }
+    TourSpan<const Index> tour(int g) const {
+        return TourSpan<const Index>(base + (std::size_t) g * stride_, num_cities);
+    }
+
+    double &length(int g) { return lengths[g]; }
+    double length(int g) const { return lengths[g]; }
+
+    bool isDirty(int g) const { return dirty[g] != 0; }
+    void setDirty(int g, bool is_dirty) { dirty[g] = is_dirty; }
+
+    // Copies genome G of FROM, with its length and flag, over genome TO.
+    void copy(int to, const GenomeArena &from, int g);
+};
+
+template<class Index>
+void GenomeArena<Index>::reset(int num_genomes, int num_cities)
+{
+    const int per_line = ARENA_ALIGNMENT / sizeof(Index);
+
+    this->num_genomes = num_genomes;
+    this->num_cities = num_cities;
+    stride_ = (num_cities + per_line - 1) / per_line * per_line;
+
+    std::size_t needed = (std::size_t) num_genomes * stride_ + per_line;
+    if (storage.size() < needed)
+    {
+        storage.resize(needed);
+    }
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage.data());
+    std::uintptr_t aligned = (address + ARENA_ALIGNMENT - 1)
+        & ~(std::uintptr_t) (ARENA_ALIGNMENT - 1);
+    base = storage.data() + (aligned - address) / sizeof(Index);
+
+    lengths.assign(num_genomes, 1e9);
+    dirty.assign(num_genomes, 1);
+}
+
+template<class Index>
+void GenomeArena<Index>::copy(int to, const GenomeArena &from, int g)
+{
+    TourSpan<const Index> source = from.tour(g);
+
+    std::copy(source.begin(), source.end(), tour(to).begin());
+    lengths[to] = from.lengths[g];
+    dirty[to] = from.dirty[g];
+}
+
+#endif /* End of include guard for GenomeArena.hh */
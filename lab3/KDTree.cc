@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "KDTree.hh"
+
+
+/*! Builds a tree over the points of CLOUD in O(n log n). */
+KDTree::KDTree(const PointCloud &cloud)
+    : num_points(cloud.size()), num_dims(cloud.dims()), ids(cloud.size()),
+      position(cloud.size()), coords(3 * (std::size_t) cloud.size()),
+      axis(cloud.size(), 0)
+{
+    int i;
+
+    for (i = 0; i < num_points; i++)
+    {
+        ids[i] = i;
+    }
+
+    /* Partition the ids using the original coordinates, then lay the
+       coordinates out in tree order. */
+    std::vector<double> src(3 * (std::size_t) num_points);
+    for (i = 0; i < num_points; i++)
+    {
+        src[3 * i] = cloud.getX(i);
+        src[3 * i + 1] = cloud.getY(i);
+        src[3 * i + 2] = cloud.getZ(i);
+    }
+    coords.swap(src);
+
+    build(0, num_points);
+
+    for (i = 0; i < num_points; i++)
+    {
+        src[3 * i] = coords[3 * ids[i]];
+        src[3 * i + 1] = coords[3 * ids[i] + 1];
+        src[3 * i + 2] = coords[3 * ids[i] + 2];
+        position[ids[i]] = i;
+    }
+    coords.swap(src);
+}
+
+/*! Builds a tree over POINTS. */
+KDTree::KDTree(const std::vector<Point> &points)
+    : KDTree(buildPointCloud(points))
+{
+    // no-op
+}
+
+/*! Arranges tree positions [LO, HI) as a subtree.  While building, COORDS is
+    still indexed by city rather than by tree position.
+
+    Splits on the axis along which the range is widest, at the median, so the
+    tree stays balanced whatever the point distribution. */
+void KDTree::build(int lo, int hi)
+{
+    double lo_c[3], hi_c[3];
+    int mid, a, best, p;
+
+    if (hi - lo <= KD_TREE_LEAF_SIZE)
+    {
+        return;
+    }
+
+    for (a = 0; a < num_dims; a++)
+    {
+        lo_c[a] = hi_c[a] = coords[3 * ids[lo] + a];
+    }
+    for (p = lo + 1; p < hi; p++)
+    {
+        for (a = 0; a < num_dims; a++)
+        {
+            lo_c[a] = std::min(lo_c[a], coords[3 * ids[p] + a]);
+            hi_c[a] = std::max(hi_c[a], coords[3 * ids[p] + a]);
+        }
+    }
+
+    best = 0;
+    for (a = 1; a < num_dims; a++)
+    {
+        if (hi_c[a] - lo_c[a] > hi_c[best] - lo_c[best])
+        {
+            best = a;
+        }
+    }
+
+    mid = lo + (hi - lo) / 2;
+    std::nth_element(ids.begin() + lo, ids.begin() + mid, ids.begin() + hi,
+        [&](int i, int j) {
+            return coords[3 * i + best] < coords[3 * j + best];
+        });
+    axis[mid] = (unsigned char) best;
+
+    build(lo, mid);
+    build(mid + 1, hi);
+}
+
+/*! Squared distance between query Q and the point at tree position P. */
+static inline double squaredDistance(const double *q, const double *p)
+{
+    double dx = q[0] - p[0];
+    double dy = q[1] - p[1];
+    double dz = q[2] - p[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/*! Offers the point at tree position P to the bounded max-heap of the K best
+    (squared distance, city) pairs found so far. */
+static inline void offer(std::vector<std::pair<double, int> > &heap, int k,
+    double d2, int id)
+{
+    if ((int) heap.size() < k)
+    {
+        heap.push_back(std::make_pair(d2, id));
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (d2 < heap.front().first)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = std::make_pair(d2, id);
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+void KDTree::searchKNearest(int lo, int hi, const double *q, int k,
+    int exclude, std::vector<std::pair<double, int> > &heap) const
+{
+    int p, mid;
+
+    if (hi - lo <= KD_TREE_LEAF_SIZE)
+    {
+        for (p = lo; p < hi; p++)
+        {
+            if (ids[p] != exclude)
+            {
+                offer(heap, k, squaredDistance(q, &coords[3 * p]), ids[p]);
+            }
+        }
+        return;
+    }
+
+    mid = lo + (hi - lo) / 2;
+    if (ids[mid] != exclude)
+    {
+        offer(heap, k, squaredDistance(q, &coords[3 * mid]), ids[mid]);
+    }
+
+    /* Descend into the side containing Q first; the other side can only hold
+       a closer point if the splitting plane is nearer than the current k-th
+       best. */
+    double diff = q[axis[mid]] - coords[3 * mid + axis[mid]];
+    if (diff < 0)
+    {
+        searchKNearest(lo, mid, q, k, exclude, heap);
+        if ((int) heap.size() < k || diff * diff < heap.front().first)
+        {
+            searchKNearest(mid + 1, hi, q, k, exclude, heap);
+        }
+    }
+    else
+    {
+        searchKNearest(mid + 1, hi, q, k, exclude, heap);
+        if ((int) heap.size() < k || diff * diff < heap.front().first)
+        {
+            searchKNearest(lo, mid, q, k, exclude, heap);
+        }
+    }
+}
+
+void KDTree::kNearest(const double q[3], int k, std::vector<int> &out,
+    int exclude) const
+{
+    std::vector<std::pair<double, int> > heap;
+    int i;
+
+    out.clear();
+    if (k <= 0)
+    {
+        return;
+    }
+
+    heap.reserve(k + 1);
+    searchKNearest(0, num_points, q, k, exclude, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    out.resize(heap.size());
+    for (i = 0; i < (int) heap.size(); i++)
+    {
+        out[i] = heap[i].second;
+    }
+}
+
+void KDTree::kNearest(const Point &p, int k, std::vector<int> &out) const
+{
+    double q[3] = { p.getX(), p.getY(), num_dims == 3 ? p.getZ() : 0.0 };
+    kNearest(q, k, out);
+}
+
+void KDTree::kNearestOf(int i, int k, std::vector<int> &out) const
+{
+    int p = position[i];
+    double q[3] = { coords[3 * p], coords[3 * p + 1], coords[3 * p + 2] };
+
+    kNearest(q, k, out, i);
+}
+
+void KDTree::searchRadius(int lo, int hi, const double *q, double r2,
+    std::vector<int> &out) const
+{
+    int p, mid;
+
+    if (hi - lo <= KD_TREE_LEAF_SIZE)
+    {
+        for (p = lo; p < hi; p++)
+        {
+            if (squaredDistance(q, &coords[3 * p]) <= r2)
+            {
+                out.push_back(ids[p]);
+            }
+        }
+        return;
+    }
+
+    mid = lo + (hi - lo) / 2;
+    if (squaredDistance(q, &coords[3 * mid]) <= r2)
+    {
+        out.push_back(ids[mid]);
+    }
+
+    double diff = q[axis[mid]] - coords[3 * mid + axis[mid]];
+    if (diff < 0 || diff * diff <= r2)
+    {
+        searchRadius(lo, mid, q, r2, out);
+    }
+    if (diff >= 0 || diff * diff <= r2)
+    {
+        searchRadius(mid + 1, hi, q, r2, out);
+    }
+}
+
+void KDTree::radius(const double q[3], double r, std::vector<int> &out) const
+{
+    out.clear();
+    searchRadius(0, num_points, q, r * r, out);
+}
+
+void KDTree::radius(const Point &p, double r, std::vector<int> &out) const
+{
+    double q[3] = { p.getX(), p.getY(), num_dims == 3 ? p.getZ() : 0.0 };
+    radius(q, r, out);
+}
+
+/*! Answers a k-nearest query for every city.  Queries are issued in tree
+    order, so consecutive queries on a thread visit the same parts of the
+    tree, and each thread takes one contiguous block of them. */
+std::vector<int> KDTree::allKNearest(int k, int num_threads) const
+{
+    std::vector<int> result((std::size_t) num_points * k, -1);
+    std::vector<std::thread> workers;
+    int found = std::min(k, num_points - 1);
+    int t;
+
+    if (found <= 0)
+    {
+        return result;
+    }
+
+    num_threads = std::max(1, std::min(num_threads, num_points));
+
+    auto work = [&](int t) {
+        std::vector<std::pair<double, int> > heap;
+        int begin = (int) ((long long) num_points * t / num_threads);
+        int end = (int) ((long long) num_points * (t + 1) / num_threads);
+        int p, j;
+
+        heap.reserve(found + 1);
+        for (p = begin; p < end; p++)
+        {
+            heap.clear();
+            searchKNearest(0, num_points, &coords[3 * p], found, ids[p], heap);
+            std::sort_heap(heap.begin(), heap.end());
+
+            int *row = &result[(std::size_t) ids[p] * k];
+            for (j = 0; j < (int) heap.size(); j++)
+            {
+                row[j] = heap[j].second;
+            }
+        }
+    };
+
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(work, t));
+    }
+    work(0);
+
+    for (t = 0; t < (int) workers.size(); t++)
+    {
+        workers[t].join();
+    }
+
+    return result;
+}
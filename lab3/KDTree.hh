@@ -0,0 +1,58 @@
+#ifndef _KD_TREE_H_
+#define _KD_TREE_H_
+
+#include <utility>
+#include <vector>
+
+#include "Point.hh"
+#include "PointCloud.hh"
+
+// Subtrees with at most this many points are scanned linearly.
+#define KD_TREE_LEAF_SIZE 8
+
+// A static k-d tree over the cities of a TSP instance.
+// The tree is implicit: points are permuted so that every subtree occupies a
+// contiguous range whose median element is the splitting point, and the
+// coordinates are copied in that order so queries walk memory sequentially.
+// Query results are city indices of the original point set.
+class KDTree {
+
+private:
+    int num_points;
+    int num_dims;
+    std::vector<int> ids;               // tree position -> city index
+    std::vector<int> position;          // city index -> tree position
+    std::vector<double> coords;         // 3 coordinates per tree position
+    std::vector<unsigned char> axis;    // split axis of each range's median
+
+    void build(int lo, int hi);
+    void searchKNearest(int lo, int hi, const double *q, int k, int exclude,
+        std::vector<std::pair<double, int> > &heap) const;
+    void searchRadius(int lo, int hi, const double *q, double r2,
+        std::vector<int> &out) const;
+
+public:
+    KDTree(const PointCloud &cloud);
+    KDTree(const std::vector<Point> &points);
+
+    int size() const { return num_points; }
+
+    // The K cities nearest to Q, closest first, skipping city EXCLUDE.
+    void kNearest(const double q[3], int k, std::vector<int> &out,
+        int exclude = -1) const;
+    void kNearest(const Point &p, int k, std::vector<int> &out) const;
+
+    // The K cities nearest to city I, not counting I itself.
+    void kNearestOf(int i, int k, std::vector<int> &out) const;
+
+    // All cities within distance R of Q, in no particular order.
+    void radius(const double q[3], double r, std::vector<int> &out) const;
+    void radius(const Point &p, double r, std::vector<int> &out) const;
+
+    // Neighbor lists of every city: entry i * k + j is the (j + 1)-th nearest
+    // neighbor of city i, or -1 if there are fewer than k other cities.
+    // Queries are split across NUM_THREADS threads.
+    std::vector<int> allKNearest(int k, int num_threads) const;
+};
+
+#endif /* End of include guard for KDTree.hh */
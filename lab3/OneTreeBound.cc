@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+#include "OneTreeBound.hh"
+
+// The exact 1-tree is re-computed only after the ascent has run for this
+// many times as long as the last re-computation took.
+#define ONE_TREE_CHECK_RATIO 4.0
+
+/*! Builds the candidate graph over the cities of DIST from NEIGHBORS, the
+    K nearest neighbors of each city as returned by KDTree::allKNearest():
+    each city is joined to its neighbors and to every city that lists it. */
+OneTreeBound::OneTreeBound(const DistanceStore &dist,
+    const std::vector<int> &neighbors, int k)
+    : dist(dist), n(dist.size()), first(dist.size() + 1, 0), best_bound(0.0),
+      upper(std::numeric_limits<double>::infinity()), stopping(false),
+      finished(false), iterations(0)
+{
+    int i, j;
+
+    /* Count each edge at both ends, then fill and de-duplicate the lists. */
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < k; j++)
+        {
+            int c = neighbors[(std::size_t) i * k + j];
+            if (c >= 0)
+            {
+                first[i + 1]++;
+                first[c + 1]++;
+            }
+        }
+    }
+    for (i = 0; i < n; i++)
+    {
+        first[i + 1] += first[i];
+    }
+
+    std::vector<int> next(first.begin(), first.end() - 1);
+    adjacent.resize(first[n]);
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < k; j++)
+        {
+            int c = neighbors[(std::size_t) i * k + j];
+            if (c >= 0)
+            {
+                adjacent[next[i]++] = c;
+                adjacent[next[c]++] = i;
+            }
+        }
+    }
+
+    int kept = 0;
+    for (i = 0; i < n; i++)
+    {
+        int begin = first[i];
+        std::sort(adjacent.begin() + begin, adjacent.begin() + first[i + 1]);
+        int end = std::unique(adjacent.begin() + begin,
+            adjacent.begin() + first[i + 1]) - adjacent.begin();
+
+        first[i] = kept;
+        for (j = begin; j < end; j++)
+        {
+            adjacent[kept++] = adjacent[j];
+        }
+    }
+    first[n] = kept;
+    adjacent.resize(kept);
+
+    length.resize(kept);
+    for (i = 0; i < n; i++)
+    {
+        for (j = first[i]; j < first[i + 1]; j++)
+        {
+            length[j] = edge(i, adjacent[j]);
+        }
+    }
+
+    /* Any tour bounds the optimum from above; the numbering order will do
+       until a better one is offered. */
+    std::vector<int> order(n);
+    for (i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    if (n > 0)
+    {
+        upper = dist.tourLength(order);
+    }
+}
+
+OneTreeBound::~OneTreeBound()
+{
+    stop();
+}
+
+/*! Length of the undirected edge between cities I and J: the cheaper
+    direction, if they differ. */
+double OneTreeBound::edge(int i, int j) const
+{
+    return dist.symmetric() ? dist.distance(i, j)
+        : std::min(dist.distance(i, j), dist.distance(j, i));
+}
+
+/*! Starts the ascent on a background thread. */
+void OneTreeBound::start()
+{
+    if (n >= 3 && !worker.joinable())
+    {
+        worker = std::thread(&OneTreeBound::ascend, this);
+    }
+}
+
+/*! Stops the ascent and waits for its thread; the bound keeps its value. */
+void OneTreeBound::stop()
+{
+    stopping = true;
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+/*! Lowers the known upper bound to LENGTH if that is shorter. */
+void OneTreeBound::offerTour(double length)
+{
+    double current = upper.load(std::memory_order_relaxed);
+
+    while (length < current
+        && !upper.compare_exchange_weak(current, length, std::memory_order_relaxed))
+    {
+        // no-op; CURRENT was reloaded
+    }
+}
+
+/*! Computes a minimum 1-tree over the candidate edges only, under the costs
+    d(i, j) + PI[i] + PI[j], by Prim's algorithm with a heap.  If the
+    candidate graph is not connected, each component gets its own tree.
+    Returns the weight minus 2 sum(PI) and stores each city's degree in
+    DEGREE.  This is not a bound: the true 1-tree may use other edges. */
+double OneTreeBound::sparseOneTree(const std::vector<double> &pi,
+    std::vector<int> &degree) const
+{
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > heap;
+    std::vector<double> key(n, std::numeric_limits<double>::infinity());
+    std::vector<int> from(n, -1);
+    std::vector<char> in_tree(n, 0);
+    double weight = 0.0, pi_sum = 0.0;
+    int i, e, root = 1;
+
+    std::fill(degree.begin(), degree.end(), 0);
+
+    while (true)
+    {
+        /* Start a tree at the next city not yet reached. */
+        while (root < n && in_tree[root])
+        {
+            root++;
+        }
+        if (root == n)
+        {
+            break;
+        }
+        key[root] = 0.0;
+        heap.push(Entry(0.0, root));
+
+        while (!heap.empty())
+        {
+            int u = heap.top().second;
+            double w = heap.top().first;
+            heap.pop();
+            if (in_tree[u] || w > key[u])
+            {
+                continue;
+            }
+
+            in_tree[u] = 1;
+            weight += w;
+            if (from[u] >= 0)
+            {
+                degree[u]++;
+                degree[from[u]]++;
+            }
+
+            for (e = first[u]; e < first[u + 1]; e++)
+            {
+                int v = adjacent[e];
+                double c = length[e] + pi[u] + pi[v];
+                if (v != 0 && !in_tree[v] && c < key[v])
+                {
+                    key[v] = c;
+                    from[v] = u;
+                    heap.push(Entry(c, v));
+                }
+            }
+        }
+    }
+
+    /* The two cheapest candidate edges at city 0. */
+    double best[2] = { std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::infinity() };
+    int ends[2] = { -1, -1 };
+    for (e = first[0]; e < first[1]; e++)
+    {
+        double c = length[e] + pi[0] + pi[adjacent[e]];
+        if (c < best[0])
+        {
+            best[1] = best[0];
+            ends[1] = ends[0];
+            best[0] = c;
+            ends[0] = adjacent[e];
+        }
+        else if (c < best[1])
+        {
+            best[1] = c;
+            ends[1] = adjacent[e];
+        }
+    }
+    for (i = 0; i < 2; i++)
+    {
+        if (ends[i] >= 0)
+        {
+            weight += best[i];
+            degree[0]++;
+            degree[ends[i]]++;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        pi_sum += pi[i];
+    }
+
+    return weight - 2 * pi_sum;
+}
+
+/*! Computes the minimum 1-tree over all edges under multipliers PI, as in
+    sparseOneTree(), by Prim's algorithm on the dense graph.  This is a true
+    lower bound on every tour.  Returns minus infinity if stopped midway.
+
+    Complexity: O(n^2). */
+double OneTreeBound::denseOneTree(const std::vector<double> &pi) const
+{
+    std::vector<double> key(n, std::numeric_limits<double>::infinity());
+    std::vector<char> in_tree(n, 0);
+    double weight = 0.0, pi_sum = 0.0;
+    int i, j;
+
+    key[1] = 0.0;
+    for (int added = 1; added < n; added++)
+    {
+        if (added % 1024 == 0 && stopping.load(std::memory_order_relaxed))
+        {
+            return -std::numeric_limits<double>::infinity();
+        }
+
+        int u = -1;
+        for (i = 1; i < n; i++)
+        {
+            if (!in_tree[i] && (u < 0 || key[i] < key[u]))
+            {
+                u = i;
+            }
+        }
+        in_tree[u] = 1;
+        weight += key[u];
+
+        for (j = 1; j < n; j++)
+        {
+            if (!in_tree[j])
+            {
+                double c = edge(u, j) + pi[u] + pi[j];
+                if (c < key[j])
+                {
+                    key[j] = c;
+                }
+            }
+        }
+    }
+
+    double best[2] = { std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::infinity() };
+    for (j = 1; j < n; j++)
+    {
+        double c = edge(0, j) + pi[0] + pi[j];
+        if (c < best[0])
+        {
+            best[1] = best[0];
+            best[0] = c;
+        }
+        else if (c < best[1])
+        {
+            best[1] = c;
+        }
+    }
+    weight += best[0] + best[1];
+
+    for (i = 0; i < n; i++)
+    {
+        pi_sum += pi[i];
+    }
+
+    return weight - 2 * pi_sum;
+}
+
+/*! Subgradient ascent (Held and Karp, 1971), as in lab2's branch and bound
+    but on the candidate graph: cities of degree above 2 in the 1-tree are
+    made more expensive and leaves cheaper, with a step that shrinks
+    whenever the bound stops improving.  The best multipliers are checked
+    against the dense graph from time to time, and once more at the end.
+    The ascent has converged if the step shrank to nothing or the 1-tree
+    became a tour, not if stop() cut it short. */
+void OneTreeBound::ascend()
+{
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> pi(n, 0.0), best_pi(n, 0.0);
+    std::vector<int> degree(n);
+    double best_sparse = -std::numeric_limits<double>::infinity();
+    double step_scale = 2.0, check_seconds = 0.0;
+    int stalled = 0, period = std::min(100, std::max(5, n / 2)), i;
+    bool unchecked = false, found_tour = false;
+    Clock::time_point last_check = Clock::now();
+
+    /* Publishes the dense bound under the best multipliers so far. */
+    auto check = [&]() {
+        Clock::time_point started = Clock::now();
+        double bound = denseOneTree(best_pi);
+
+        if (bound > best_bound.load())
+        {
+            best_bound = bound;
+        }
+        last_check = Clock::now();
+        check_seconds = std::chrono::duration<double>(last_check - started).count();
+        unchecked = false;
+    };
+
+    while (!stopping.load(std::memory_order_relaxed) && step_scale > 1e-6)
+    {
+        double w = sparseOneTree(pi, degree);
+        iterations++;
+
+        if (w > best_sparse)
+        {
+            best_sparse = w;
+            best_pi = pi;
+            stalled = 0;
+            unchecked = true;
+        }
+        else if (++stalled >= period)
+        {
+            step_scale /= 2;
+            stalled = 0;
+        }
+
+        double norm = 0.0;
+        for (i = 0; i < n; i++)
+        {
+            norm += (degree[i] - 2) * (degree[i] - 2);
+        }
+        /* A 1-tree with all degrees 2 is a tour; nothing is left to gain. */
+        if (norm == 0.0)
+        {
+            found_tour = true;
+            break;
+        }
+
+        /* The sparse weight can exceed the known tour; keep stepping then. */
+        double gap = std::max(upper.load(std::memory_order_relaxed) - w,
+            1e-3 * std::fabs(w));
+        double step = step_scale * gap / norm;
+        for (i = 0; i < n; i++)
+        {
+            pi[i] += step * (degree[i] - 2);
+        }
+
+        if (unchecked && std::chrono::duration<double>(Clock::now()
+            - last_check).count() >= ONE_TREE_CHECK_RATIO * check_seconds)
+        {
+            check();
+        }
+    }
+
+    if (unchecked && !stopping.load())
+    {
+        check();
+    }
+    if (found_tour || step_scale <= 1e-6)
+    {
+        finished = true;
+    }
+}
+
+/*! Lists the K cities nearest each city of DIST, closest first, by sorting
+    every row of undirected edge lengths; entries past the last other city
+    are -1. */
+std::vector<int> nearestByCost(const DistanceStore &dist, int k)
+{
+    int n = dist.size(), i, j;
+    std::vector<int> neighbors((std::size_t) n * k, -1);
+    std::vector<std::pair<double, int> > row;
+
+    for (i = 0; i < n; i++)
+    {
+        row.clear();
+        for (j = 0; j < n; j++)
+        {
+            if (j != i)
+            {
+                row.push_back(std::make_pair(std::min(dist.distance(i, j),
+                    dist.distance(j, i)), j));
+            }
+        }
+
+        int m = std::min(k, (int) row.size());
+        std::partial_sort(row.begin(), row.begin() + m, row.end());
+        for (j = 0; j < m; j++)
+        {
+            neighbors[(std::size_t) i * k + j] = row[j].second;
+        }
+    }
+
+    return neighbors;
+}
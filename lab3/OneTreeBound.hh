@@ -0,0 +1,71 @@
+#ifndef _ONE_TREE_BOUND_H_
+#define _ONE_TREE_BOUND_H_
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "DistanceStore.hh"
+
+// Nearest neighbors per city in the candidate graph the ascent works on.
+#define ONE_TREE_NEIGHBORS 10
+
+// The Held-Karp lower bound on the length of the shortest tour, computed on
+// a background thread while a heuristic searches for tours.
+//
+// The bound is the weight of a minimum 1-tree (a spanning tree of cities
+// 1 .. n - 1 plus two edges at city 0) under costs d(i, j) + pi[i] + pi[j],
+// minus 2 sum(pi).  Subgradient ascent adjusts the multipliers pi using
+// 1-trees over the sparse graph of each city's nearest neighbors, which
+// costs O(n k log n) per step.  A sparse 1-tree can be heavier than the true
+// one, so whenever the multipliers have improved, the bound is re-computed
+// with Prim's algorithm over all O(n^2) edges; only those values are
+// published.  On an asymmetric instance every edge counts at the cheaper of
+// its two directions, which still bounds every directed tour.
+class OneTreeBound {
+
+private:
+    const DistanceStore &dist;
+    int n;
+    std::vector<int> first;             // candidate edges of city i are
+    std::vector<int> adjacent;          // adjacent[first[i] .. first[i + 1] - 1]
+    std::vector<double> length;         // with these lengths
+
+    std::atomic<double> best_bound;     // best published bound
+    std::atomic<double> upper;          // length of the shortest known tour
+    std::atomic<bool> stopping;
+    std::atomic<bool> finished;
+    std::atomic<int> iterations;
+    std::thread worker;
+
+    double edge(int i, int j) const;
+    double sparseOneTree(const std::vector<double> &pi,
+        std::vector<int> &degree) const;
+    double denseOneTree(const std::vector<double> &pi) const;
+    void ascend();
+
+public:
+    OneTreeBound(const DistanceStore &dist, const std::vector<int> &neighbors,
+        int k);
+    ~OneTreeBound();
+
+    void start();
+    void stop();
+
+    // Tells the ascent about a tour of length LENGTH; shorter tours give
+    // better step sizes.
+    void offerTour(double length);
+
+    // The best lower bound so far, or 0 before the first one is known.
+    double bound() const { return best_bound.load(); }
+    // True once the ascent has run its course rather than been stopped.
+    bool converged() const { return finished.load(); }
+    int steps() const { return iterations.load(); }
+};
+
+// The K cities nearest each city of DIST by the cheaper direction of each
+// edge, in the layout of KDTree::allKNearest(), for instances without
+// coordinates.  Takes O(n^2) lookups.
+std::vector<int> nearestByCost(const DistanceStore &dist, int k);
+
+#endif /* End of include guard for OneTreeBound.hh */
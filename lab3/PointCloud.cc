@@ -0,0 +1,263 @@
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "PointCloud.hh"
+
+#if defined(__AVX2__)
+/*! Gathers BASE[IDX[0..3]] into one register.  Uses the masked form with an
+    explicit zero source to avoid reading an undefined merge operand. */
+static inline __m256d gather4(const double *base, __m128i idx)
+{
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, idx,
+        _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+#endif
+
+/*! Constructs an empty point cloud. */
+PointCloud::PointCloud()
+    : num_points(0), num_dims(3), x_ptr(nullptr), y_ptr(nullptr), z_ptr(nullptr)
+{
+    // no-op
+}
+
+/*! Constructs a view of N points whose coordinates are in the arrays XS, YS
+    and ZS, which must stay valid for the life of the view.  ZS is null for a
+    planar cloud.  The arrays must be POINT_CLOUD_ALIGN-byte aligned. */
+PointCloud::PointCloud(const double *xs, const double *ys, const double *zs,
+    int n)
+    : num_points(n), num_dims(zs == nullptr ? 2 : 3),
+      x_ptr(xs), y_ptr(ys), z_ptr(zs)
+{
+    // no-op
+}
+
+/*! Copies OTHER.  An owning cloud's arrays are duplicated; a view stays a
+    view of the same arrays. */
+PointCloud::PointCloud(const PointCloud &other)
+    : num_points(other.num_points), num_dims(other.num_dims),
+      x_coords(other.x_coords), y_coords(other.y_coords),
+      z_coords(other.z_coords),
+      x_ptr(other.x_ptr), y_ptr(other.y_ptr), z_ptr(other.z_ptr)
+{
+    if (other.x_ptr == other.x_coords.data())
+    {
+        pointAtStorage();
+    }
+}
+
+PointCloud &PointCloud::operator = (const PointCloud &other)
+{
+    if (this != &other)
+    {
+        PointCloud copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+/*! Makes an owning cloud read from its own arrays. */
+void PointCloud::pointAtStorage()
+{
+    x_ptr = x_coords.data();
+    y_ptr = y_coords.data();
+    z_ptr = num_dims == 3 ? z_coords.data() : nullptr;
+}
+
+/*! Builds a cloud over POINTS, choosing the representation from the input:
+    if every point has z = 0 the cloud is planar and its kernels never touch
+    a z coordinate. */
+PointCloud buildPointCloud(const std::vector<Point> &points)
+{
+    std::vector<Point2> planar;
+
+    for (const Point &p : points)
+    {
+        if (p.getZ() != 0.0)
+        {
+            return PointCloud(points);
+        }
+    }
+
+    planar.reserve(points.size());
+    for (const Point &p : points)
+    {
+        planar.push_back(Point2(p.getX(), p.getY()));
+    }
+
+    return PointCloud(planar);
+}
+
+/*! Returns point I as an array-of-structures Point. */
+Point PointCloud::getPoint(int i) const
+{
+    return Point(getX(i), getY(i), getZ(i));
+}
+
+/*! One-to-many kernel behind distancesFrom().  HAS_Z selects at compile time
+    whether the z coordinates take part, so planar clouds skip that stream. */
+template<bool HAS_Z>
+static void distancesFromKernel(const double *xs, const double *ys,
+    const double *zs, int n, int i, double *out)
+{
+    int j = 0;
+
+#if defined(__AVX2__)
+    __m256d px = _mm256_set1_pd(xs[i]);
+    __m256d py = _mm256_set1_pd(ys[i]);
+    __m256d pz = _mm256_set1_pd(HAS_Z ? zs[i] : 0.0);
+
+    for (; j + 4 <= n; j += 4)
+    {
+        __m256d dx = _mm256_sub_pd(_mm256_load_pd(xs + j), px);
+        __m256d dy = _mm256_sub_pd(_mm256_load_pd(ys + j), py);
+        __m256d sq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        if (HAS_Z)
+        {
+            __m256d dz = _mm256_sub_pd(_mm256_load_pd(zs + j), pz);
+            sq = _mm256_add_pd(sq, _mm256_mul_pd(dz, dz));
+        }
+        _mm256_storeu_pd(out + j, _mm256_sqrt_pd(sq));
+    }
+#elif defined(__SSE2__)
+    __m128d px = _mm_set1_pd(xs[i]);
+    __m128d py = _mm_set1_pd(ys[i]);
+    __m128d pz = _mm_set1_pd(HAS_Z ? zs[i] : 0.0);
+
+    for (; j + 2 <= n; j += 2)
+    {
+        __m128d dx = _mm_sub_pd(_mm_load_pd(xs + j), px);
+        __m128d dy = _mm_sub_pd(_mm_load_pd(ys + j), py);
+        __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        if (HAS_Z)
+        {
+            __m128d dz = _mm_sub_pd(_mm_load_pd(zs + j), pz);
+            sq = _mm_add_pd(sq, _mm_mul_pd(dz, dz));
+        }
+        _mm_storeu_pd(out + j, _mm_sqrt_pd(sq));
+    }
+#endif
+
+    /* Scalar tail (or the whole row when no vector unit is available). */
+    for (; j < n; j++)
+    {
+        double dx = xs[j] - xs[i];
+        double dy = ys[j] - ys[i];
+        double dz = HAS_Z ? zs[j] - zs[i] : 0.0;
+        out[j] = sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+/*! Writes the distance from point I to every point in the cloud into OUT,
+    which must have room for size() doubles. */
+void PointCloud::distancesFrom(int i, double *out) const
+{
+    assert(i >= 0 && i < size());
+
+    if (num_dims == 3)
+    {
+        distancesFromKernel<true>(xs(), ys(), zs(), size(), i, out);
+    }
+    else
+    {
+        distancesFromKernel<false>(xs(), ys(), zs(), size(), i, out);
+    }
+}
+
+/*! Tour-ordered kernel behind tourLength(); see distancesFromKernel() for
+    HAS_Z.  Returns the length of the open path ORDER[0..N-1]. */
+template<bool HAS_Z>
+static double pathLengthKernel(const double *xs, const double *ys,
+    const double *zs, const int *order, int n)
+{
+    double dist = 0.0;
+    int k = 0;
+
+#if defined(__AVX2__)
+    __m256d acc = _mm256_setzero_pd();
+
+    /* Edge k joins order[k] and order[k + 1]; process four edges at a time
+       while order[k + 4] is still in range. */
+    for (; k + 4 < n; k += 4)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (order + k));
+        __m128i b = _mm_loadu_si128((const __m128i *) (order + k + 1));
+        __m256d dx = _mm256_sub_pd(gather4(xs, a), gather4(xs, b));
+        __m256d dy = _mm256_sub_pd(gather4(ys, a), gather4(ys, b));
+        __m256d sq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        if (HAS_Z)
+        {
+            __m256d dz = _mm256_sub_pd(gather4(zs, a), gather4(zs, b));
+            sq = _mm256_add_pd(sq, _mm256_mul_pd(dz, dz));
+        }
+        acc = _mm256_add_pd(acc, _mm256_sqrt_pd(sq));
+    }
+
+    __m128d lo = _mm256_castpd256_pd128(acc);
+    __m128d hi = _mm256_extractf128_pd(acc, 1);
+    lo = _mm_add_pd(lo, hi);
+    dist = _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+#elif defined(__SSE2__)
+    __m128d acc = _mm_setzero_pd();
+
+    /* Without hardware gathers, pack two edges per register by hand. */
+    for (; k + 2 < n; k += 2)
+    {
+        int a0 = order[k], a1 = order[k + 1], a2 = order[k + 2];
+        __m128d dx = _mm_sub_pd(_mm_set_pd(xs[a1], xs[a0]),
+            _mm_set_pd(xs[a2], xs[a1]));
+        __m128d dy = _mm_sub_pd(_mm_set_pd(ys[a1], ys[a0]),
+            _mm_set_pd(ys[a2], ys[a1]));
+        __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        if (HAS_Z)
+        {
+            __m128d dz = _mm_sub_pd(_mm_set_pd(zs[a1], zs[a0]),
+                _mm_set_pd(zs[a2], zs[a1]));
+            sq = _mm_add_pd(sq, _mm_mul_pd(dz, dz));
+        }
+        acc = _mm_add_pd(acc, _mm_sqrt_pd(sq));
+    }
+
+    dist = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#endif
+
+    /* Remaining edges. */
+    for (; k < n - 1; k++)
+    {
+        int a = order[k], b = order[k + 1];
+        double dx = xs[a] - xs[b];
+        double dy = ys[a] - ys[b];
+        double dz = HAS_Z ? zs[a] - zs[b] : 0.0;
+        dist += sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    return dist;
+}
+
+/*! Returns the length of the closed tour visiting the N points named by ORDER
+    in sequence and then returning to ORDER[0].
+
+    Edges are evaluated several at a time by gathering the coordinates of
+    consecutive tour entries into vector lanes. */
+double PointCloud::tourLength(const int *order, int n) const
+{
+    double dist;
+
+    assert(n > 0);
+
+    if (num_dims == 3)
+    {
+        dist = pathLengthKernel<true>(xs(), ys(), zs(), order, n);
+    }
+    else
+    {
+        dist = pathLengthKernel<false>(xs(), ys(), zs(), order, n);
+    }
+
+    /* The edge closing the circuit. */
+    return dist + distance(order[n - 1], order[0]);
+}
@@ -0,0 +1,213 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PointFile.hh"
+
+
+/*! Offset of coordinate array A (0 = x, 1 = y, 2 = z) in a file of COUNT
+    points of PRECISION bytes each. */
+static std::size_t arrayOffset(int a, uint64_t count, int precision)
+{
+    std::size_t bytes = count * precision;
+    std::size_t padded = (bytes + POINT_CLOUD_ALIGN - 1)
+        / POINT_CLOUD_ALIGN * POINT_CLOUD_ALIGN;
+    return sizeof(PointFileHeader) + a * padded;
+}
+
+/*! Returns true if the file at PATH starts with the binary point file magic.
+    Never true for stdin ("-"), which cannot be mapped. */
+bool isPointFile(const char *path)
+{
+    char magic[sizeof(POINT_FILE_MAGIC)];
+    FILE *in;
+    bool match;
+
+    if (strcmp(path, "-") == 0 || (in = fopen(path, "rb")) == nullptr)
+    {
+        return false;
+    }
+
+    match = fread(magic, 1, sizeof(magic), in) == sizeof(magic)
+        && memcmp(magic, POINT_FILE_MAGIC, sizeof(magic)) == 0;
+    fclose(in);
+
+    return match;
+}
+
+/*! Writes CLOUD to PATH as a binary point file with PRECISION (4 or 8) bytes
+    per coordinate.  Returns false and describes the problem in ERROR on
+    failure. */
+bool writePointFile(const char *path, const PointCloud &cloud, int precision,
+    std::string &error)
+{
+    PointFileHeader header;
+    const double *arrays[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+    std::vector<char> pad(POINT_CLOUD_ALIGN, 0);
+    std::vector<float> narrow(cloud.size());
+    int a, i;
+
+    if (precision != 4 && precision != 8)
+    {
+        error = "precision must be 4 or 8 bytes";
+        return false;
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (out == nullptr)
+    {
+        error = std::string("cannot create ") + path;
+        return false;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POINT_FILE_MAGIC, sizeof(POINT_FILE_MAGIC));
+    header.dims = cloud.dims();
+    header.precision = precision;
+    header.count = cloud.size();
+    fwrite(&header, sizeof(header), 1, out);
+
+    for (a = 0; a < cloud.dims(); a++)
+    {
+        std::size_t bytes = (std::size_t) cloud.size() * precision;
+
+        if (precision == 8)
+        {
+            fwrite(arrays[a], 1, bytes, out);
+        }
+        else
+        {
+            for (i = 0; i < cloud.size(); i++)
+            {
+                narrow[i] = (float) arrays[a][i];
+            }
+            fwrite(narrow.data(), 1, bytes, out);
+        }
+
+        std::size_t end = arrayOffset(a + 1, cloud.size(), precision);
+        fwrite(pad.data(), 1, end - arrayOffset(a, cloud.size(), precision)
+            - bytes, out);
+    }
+
+    if (ferror(out) | (fclose(out) != 0))
+    {
+        error = std::string("error writing ") + path;
+        return false;
+    }
+
+    return true;
+}
+
+MappedPointFile::MappedPointFile() : base(nullptr), length(0)
+{
+    // no-op
+}
+
+MappedPointFile::~MappedPointFile()
+{
+    if (base != nullptr)
+    {
+        munmap(base, length);
+    }
+}
+
+/*! Maps the binary point file at PATH read-only and sets up cloud().  Pages
+    are only read when first touched, so opening costs the same regardless of
+    the file size.  Returns false and describes the problem in ERROR if the
+    file cannot be mapped or is malformed. */
+bool MappedPointFile::open(const char *path, std::string &error)
+{
+    struct stat st;
+    int fd, a, i;
+
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        error = std::string("cannot open ") + path;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    length = st.st_size;
+    base = length > 0 ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        base = nullptr;
+        error = std::string("cannot map ") + path;
+        return false;
+    }
+
+    const PointFileHeader *header = (const PointFileHeader *) base;
+    if (length < sizeof(PointFileHeader)
+        || memcmp(header->magic, POINT_FILE_MAGIC, sizeof(POINT_FILE_MAGIC)) != 0)
+    {
+        error = "not a binary point file";
+        return false;
+    }
+    if ((header->dims != 2 && header->dims != 3)
+        || (header->precision != 4 && header->precision != 8)
+        || header->count > (uint64_t) 0x7fffffff
+        || length < arrayOffset(header->dims, header->count, header->precision))
+    {
+        error = "corrupt binary point file header";
+        return false;
+    }
+
+    const char *bytes = (const char *) base;
+    int count = (int) header->count;
+    int dims = header->dims;
+
+    if (header->precision == 8)
+    {
+        /* Use the mapped arrays directly. */
+        const double *arrays[3] = { nullptr, nullptr, nullptr };
+        for (a = 0; a < dims; a++)
+        {
+            arrays[a] = (const double *)
+                (bytes + arrayOffset(a, count, header->precision));
+        }
+        points = PointCloud(arrays[0], arrays[1], arrays[2], count);
+    }
+    else
+    {
+        /* Widen single-precision coordinates into an owned cloud. */
+        const float *arrays[3] = { nullptr, nullptr, nullptr };
+        for (a = 0; a < dims; a++)
+        {
+            arrays[a] = (const float *)
+                (bytes + arrayOffset(a, count, header->precision));
+        }
+
+        if (dims == 2)
+        {
+            std::vector<Point2> pts(count);
+            for (i = 0; i < count; i++)
+            {
+                pts[i] = Point2(arrays[0][i], arrays[1][i]);
+            }
+            points = PointCloud(pts);
+        }
+        else
+        {
+            std::vector<Point> pts(count);
+            for (i = 0; i < count; i++)
+            {
+                pts[i] = Point(arrays[0][i], arrays[1][i], arrays[2][i]);
+            }
+            points = PointCloud(pts);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "PointIO.hh"
+
+// Size of each read from the input file.
+#define POINT_IO_BLOCK (1 << 20)
+
+
+/*! Reads the whole of the file at PATH (stdin if PATH is "-") into BUF using
+    large block reads.  Returns false if the file cannot be opened or read. */
+static bool slurp(const char *path, std::vector<char> &buf)
+{
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    std::size_t used = 0, got;
+
+    if (in == nullptr)
+    {
+        return false;
+    }
+
+    do
+    {
+        buf.resize(used + POINT_IO_BLOCK);
+        got = fread(buf.data() + used, 1, POINT_IO_BLOCK, in);
+        used += got;
+    } while (got == POINT_IO_BLOCK);
+
+    bool ok = !ferror(in);
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    buf.resize(used);
+    return ok;
+}
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*! Parses one whitespace-separated number starting at *P, advancing *P past
+    it.  Returns false if there is no number before END or the end of the
+    line. */
+static inline bool parseNumber(const char *&p, const char *end, double &val)
+{
+    while (p < end && isBlank(*p))
+    {
+        p++;
+    }
+
+    /* from_chars rejects a leading '+', which other tools may write. */
+    if (p < end && *p == '+')
+    {
+        p++;
+    }
+
+    std::from_chars_result r = std::from_chars(p, end, val);
+    if (r.ec != std::errc() || (r.ptr < end && !isBlank(*r.ptr) && *r.ptr != '\n'))
+    {
+        return false;
+    }
+
+    p = r.ptr;
+    return true;
+}
+
+/*! Returns true if only blanks remain before the end of the line at P. */
+static inline bool restOfLineBlank(const char *p, const char *end)
+{
+    while (p < end && *p != '\n')
+    {
+        if (!isBlank(*p))
+        {
+            return false;
+        }
+        p++;
+    }
+    return true;
+}
+
+static std::string lineError(long long line, const char *what)
+{
+    return "line " + std::to_string(line) + ": " + what;
+}
+
+// A slice of the input handed to one parsing thread.
+struct Chunk {
+    const char *begin, *end;
+    long long first_line;       // file line number of BEGIN
+    long long num_lines;        // newline-terminated lines in the chunk
+    long long num_points;       // non-blank lines in the chunk
+    long long first_point;      // index in POINTS of the first one
+    std::string error;
+};
+
+/*! Counts the lines and non-blank lines of CHUNK. */
+static void countChunk(Chunk &chunk)
+{
+    const char *p = chunk.begin;
+
+    chunk.num_lines = chunk.num_points = 0;
+    while (p < chunk.end)
+    {
+        const char *eol = (const char *) memchr(p, '\n', chunk.end - p);
+        if (eol == nullptr)
+        {
+            eol = chunk.end;
+        }
+        if (!restOfLineBlank(p, eol))
+        {
+            chunk.num_points++;
+        }
+        chunk.num_lines++;
+        p = eol + 1;
+    }
+}
+
+/*! Parses the points of CHUNK into POINTS starting at CHUNK.FIRST_POINT.
+    Each non-blank line must hold exactly three coordinates. */
+static bool parseChunk(Chunk &chunk, std::vector<Point> &points)
+{
+    const char *p = chunk.begin;
+    long long line = chunk.first_line;
+    std::size_t k = chunk.first_point;
+    double x, y, z;
+
+    while (p < chunk.end)
+    {
+        const char *eol = (const char *) memchr(p, '\n', chunk.end - p);
+        if (eol == nullptr)
+        {
+            eol = chunk.end;
+        }
+
+        if (!restOfLineBlank(p, eol))
+        {
+            if (!parseNumber(p, eol, x) || !parseNumber(p, eol, y)
+                || !parseNumber(p, eol, z))
+            {
+                chunk.error = lineError(line, "expected three coordinates");
+                return false;
+            }
+            if (!restOfLineBlank(p, eol))
+            {
+                chunk.error = lineError(line, "unexpected text after the coordinates");
+                return false;
+            }
+            points[k++] = Point(x, y, z);
+        }
+
+        line++;
+        p = eol + 1;
+    }
+
+    return true;
+}
+
+/*! Parses the number of points that heads a point set at *P, after any
+    blank lines, into DECLARED and advances *P to the next line.  LINE is
+    the line number of *P and is kept up to date.  Returns false and
+    describes the problem in ERROR if there is no count. */
+static bool parseCount(const char *&p, const char *end, long long &line,
+    long long &declared, std::string &error)
+{
+    while (p < end && (isBlank(*p) || *p == '\n'))
+    {
+        line += (*p == '\n');
+        p++;
+    }
+    std::from_chars_result r = std::from_chars(p, end, declared);
+    if (r.ec != std::errc() || declared < 0 || !restOfLineBlank(r.ptr, end))
+    {
+        error = lineError(line, "expected the number of points");
+        return false;
+    }
+    p = (const char *) memchr(r.ptr, '\n', end - r.ptr);
+    p = (p == nullptr) ? end : p + 1;
+    line++;
+
+    return true;
+}
+
+/*! Parses a point set in the test-N.txt format from [BEGIN, END): the number
+    of points on the first line, then one "x y z" line per point.  Blank lines
+    are ignored.  POINTS is resized once to the declared count and filled in
+    place; large inputs are split at line boundaries and parsed by up to
+    NUM_THREADS threads.
+
+    Returns false and describes the first problem in ERROR on bad input. */
+bool parsePoints(const char *begin, const char *end, std::vector<Point> &points,
+    int num_threads, std::string &error)
+{
+    const char *p = begin;
+    long long declared = 0;
+    long long line = 1;
+    int t;
+
+    /* Header: the number of points, possibly after blank lines. */
+    if (!parseCount(p, end, line, declared, error))
+    {
+        return false;
+    }
+
+    /* Split the body into chunks that end on line boundaries. */
+    num_threads = std::max(1, std::min(num_threads,
+        (int) (declared / POINT_IO_MIN_LINES_PER_THREAD)));
+    std::vector<Chunk> chunks(num_threads);
+    for (t = 0; t < num_threads; t++)
+    {
+        const char *cut = p + (end - p) * (t + 1) / num_threads;
+        if (t + 1 < num_threads)
+        {
+            const char *eol = (const char *) memchr(cut, '\n', end - cut);
+            cut = (eol == nullptr) ? end : eol + 1;
+        }
+        chunks[t].begin = (t == 0) ? p : chunks[t - 1].end;
+        chunks[t].end = std::max(cut, chunks[t].begin);
+    }
+    chunks[num_threads - 1].end = end;
+
+    /* Pass 1: count lines so every chunk knows where its points go. */
+    std::vector<std::thread> workers;
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(countChunk, std::ref(chunks[t])));
+    }
+    countChunk(chunks[0]);
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+    workers.clear();
+
+    long long total = 0;
+    for (t = 0; t < num_threads; t++)
+    {
+        chunks[t].first_line = line;
+        chunks[t].first_point = total;
+        line += chunks[t].num_lines;
+        total += chunks[t].num_points;
+    }
+
+    if (total != declared)
+    {
+        error = "expected " + std::to_string(declared) + " points but found "
+            + std::to_string(total);
+        return false;
+    }
+
+    /* Pass 2: parse straight into the final vector. */
+    points.resize(declared);
+
+    std::vector<char> ok(num_threads);
+    for (t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread([&, t]() {
+            ok[t] = parseChunk(chunks[t], points);
+        }));
+    }
+    ok[0] = parseChunk(chunks[0], points);
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+
+    for (t = 0; t < num_threads; t++)
+    {
+        if (!ok[t])
+        {
+            error = chunks[t].error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! Reads a point set in the test-N.txt format from the file at PATH, or from
+    stdin if PATH is "-".  See parsePoints().
+
+    Returns false and describes the problem in ERROR on failure. */
+bool readPoints(const char *path, std::vector<Point> &points, int num_threads,
+    std::string &error)
+{
+    std::vector<char> buf;
+
+    if (!slurp(path, buf))
+    {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+
+    return parsePoints(buf.data(), buf.data() + buf.size(), points,
+        num_threads, error);
+}
+
+/*! Reads any number of point sets in the test-N.txt format, one after
+    another, from the file at PATH, or from stdin if PATH is "-".  Each set
+    is its number of points followed by that many "x y z" lines, and blank
+    lines are ignored.  Sets are small, so each is parsed serially into its
+    own entry of INSTANCES.
+
+    Returns false and describes the problem in ERROR on failure. */
+bool readInstances(const char *path, std::vector<std::vector<Point> > &instances,
+    std::string &error)
+{
+    std::vector<char> buf;
+    long long line = 1, declared;
+
+    if (!slurp(path, buf))
+    {
+        error = std::string("cannot read ") + path;
+        return false;
+    }
+
+    const char *p = buf.data(), *end = p + buf.size();
+    instances.clear();
+    while (true)
+    {
+        /* Stop at the end, or read the next header. */
+        while (p < end && (isBlank(*p) || *p == '\n'))
+        {
+            line += (*p == '\n');
+            p++;
+        }
+        if (p == end)
+        {
+            break;
+        }
+        if (!parseCount(p, end, line, declared, error))
+        {
+            return false;
+        }
+
+        /* The set ends with its DECLARED-th non-blank line. */
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.first_line = line;
+        chunk.first_point = 0;
+        long long found = 0;
+        while (found < declared && p < end)
+        {
+            const char *eol = (const char *) memchr(p, '\n', end - p);
+            if (eol == nullptr)
+            {
+                eol = end;
+            }
+            found += !restOfLineBlank(p, eol);
+            line++;
+            p = (eol == end) ? end : eol + 1;
+        }
+        chunk.end = p;
+
+        if (found != declared)
+        {
+            error = "instance " + std::to_string(instances.size() + 1)
+                + ": expected " + std::to_string(declared)
+                + " points but found " + std::to_string(found);
+            return false;
+        }
+
+        instances.push_back(std::vector<Point>(declared));
+        if (!parseChunk(chunk, instances.back()))
+        {
+            error = chunk.error;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,116 @@
+#include <cassert>
+
+#include "RandomStream.hh"
+
+/*! Rotates X left by K bits. */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*! Mixes SEED and INDEX through two rounds of SplitMix64. */
+uint64_t deriveSeed(uint64_t seed, uint64_t index)
+{
+    uint64_t state = seed;
+    uint64_t mixed = splitMix64(state) ^ index;
+
+    return splitMix64(mixed);
+}
+
+/*! Fills the state from SEED with SplitMix64, as the xoshiro authors
+    recommend; the result is never all zero. */
+RandomStream::RandomStream(uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        s[i] = splitMix64(seed);
+    }
+}
+
+RandomStream RandomStream::stream(uint64_t seed, int index)
+{
+    RandomStream rng(seed);
+
+    for (int i = 0; i < index; i++)
+    {
+        rng.jump();
+    }
+
+    return rng;
+}
+
+/*! Returns the next word and advances the state. */
+RandomStream::result_type RandomStream::operator()()
+{
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/*! Maps the high 32 bits of a draw onto [0, N) by multiplication,
+    rejecting the few draws that would make some results more likely than
+    others (Lemire, 2019). */
+int RandomStream::below(int n)
+{
+    assert(n > 0);
+
+    uint64_t m = ((*this)() >> 32) * (uint64_t) n;
+    uint32_t low = (uint32_t) m;
+
+    if (low < (uint32_t) n)
+    {
+        uint32_t threshold = (uint32_t) -n % (uint32_t) n;
+        while (low < threshold)
+        {
+            m = ((*this)() >> 32) * (uint64_t) n;
+            low = (uint32_t) m;
+        }
+    }
+
+    return (int) (m >> 32);
+}
+
+/*! The jump polynomial published with xoshiro256**. */
+void RandomStream::jump()
+{
+    static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL,
+        0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+
+    for (uint64_t word : JUMP)
+    {
+        for (int b = 0; b < 64; b++)
+        {
+            if (word & ((uint64_t) 1 << b))
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    t[i] ^= s[i];
+                }
+            }
+            (*this)();
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        s[i] = t[i];
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef _RANDOM_STREAM_H_
+#define _RANDOM_STREAM_H_
+
+#include <cstdint>
+
+// Expands one 64-bit STATE into a sequence of well-mixed words (SplitMix64,
+// Steele, Lea and Flood), advancing STATE.  Used to seed RandomStream and to
+// derive seeds from a seed and an index.
+uint64_t splitMix64(uint64_t &state);
+
+// A seed for item INDEX of a run started from SEED, different for every
+// index and unrelated to SEED + INDEX.
+uint64_t deriveSeed(uint64_t seed, uint64_t index);
+
+// The xoshiro256** generator (Blackman and Vigna, 2018): 256 bits of state,
+// a few shifts and rotations per 64-bit word, and a jump function that
+// advances it by 2^128 steps.  Each RandomStream is owned by one thread, so
+// unlike rand() there is no hidden shared state to contend for, and a run
+// seeded the same way draws the same numbers.  Satisfies the standard
+// UniformRandomBitGenerator requirements, so std::shuffle can use it.
+class RandomStream {
+
+private:
+    uint64_t s[4];
+
+public:
+    typedef uint64_t result_type;
+
+    explicit RandomStream(uint64_t seed = 0);
+
+    // Stream INDEX of SEED: the generator seeded with SEED, jumped INDEX
+    // times, so streams of one seed never overlap within 2^128 draws.
+    static RandomStream stream(uint64_t seed, int index);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    result_type operator()();
+
+    // A uniformly distributed integer in [0, N), for 0 < N < 2^32.
+    int below(int n);
+
+    // Advances the state by 2^128 draws.
+    void jump();
+};
+
+#endif /* End of include guard for RandomStream.hh */
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <utility>
+
+#include "SpaceCurve.hh"
+
+/*! Sets KIND from NAME, which is "hilbert", "morton" or "none".  Returns
+    false if NAME is not recognized. */
+bool parseCurveKind(const std::string &name, CurveKind &kind)
+{
+    if (name == "hilbert")
+    {
+        kind = CURVE_HILBERT;
+    }
+    else if (name == "morton")
+    {
+        kind = CURVE_MORTON;
+    }
+    else if (name == "none")
+    {
+        kind = CURVE_NONE;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*! Interleaves the SPACE_CURVE_BITS-bit values COORDS[0..DIMS-1], most
+    significant bit first, with COORDS[0] supplying the leading bit of each
+    group. */
+static uint64_t interleave(const uint32_t coords[], int dims)
+{
+    uint64_t key = 0;
+    int bit, d;
+
+    for (bit = SPACE_CURVE_BITS - 1; bit >= 0; bit--)
+    {
+        for (d = 0; d < dims; d++)
+        {
+            key = (key << 1) | ((coords[d] >> bit) & 1);
+        }
+    }
+
+    return key;
+}
+
+/*! Returns the position along the Z-order (Morton) curve of the grid cell
+    COORDS. */
+uint64_t mortonKey(const uint32_t coords[], int dims)
+{
+    return interleave(coords, dims);
+}
+
+/*! Returns the position along the Hilbert curve of the grid cell COORDS,
+    which is overwritten.  Uses Skilling's transform ("Programming the
+    Hilbert curve", 2004): the axes are turned into the curve's transposed
+    index in place, whose interleaved bits are the key. */
+uint64_t hilbertKey(uint32_t coords[], int dims)
+{
+    uint32_t m = 1u << (SPACE_CURVE_BITS - 1), p, q, t;
+    int d;
+
+    /* Undo the rotations and reflections of each sub-cube. */
+    for (q = m; q > 1; q >>= 1)
+    {
+        p = q - 1;
+        for (d = 0; d < dims; d++)
+        {
+            if (coords[d] & q)
+            {
+                coords[0] ^= p;
+            }
+            else
+            {
+                t = (coords[0] ^ coords[d]) & p;
+                coords[0] ^= t;
+                coords[d] ^= t;
+            }
+        }
+    }
+
+    /* Gray-encode. */
+    for (d = 1; d < dims; d++)
+    {
+        coords[d] ^= coords[d - 1];
+    }
+    t = 0;
+    for (q = m; q > 1; q >>= 1)
+    {
+        if (coords[dims - 1] & q)
+        {
+            t ^= q - 1;
+        }
+    }
+    for (d = 0; d < dims; d++)
+    {
+        coords[d] ^= t;
+    }
+
+    return interleave(coords, dims);
+}
+
+/*! Maps V from [LO, LO + SPAN] onto the curve's integer grid. */
+static uint32_t quantize(double v, double lo, double span)
+{
+    const double cells = (double) ((1u << SPACE_CURVE_BITS) - 1);
+
+    if (span <= 0.0)
+    {
+        return 0;
+    }
+    return (uint32_t) ((v - lo) / span * cells);
+}
+
+/*! Sorts the cities of CLOUD along curve KIND.  The bounding box is scaled
+    uniformly so that the curve does not distort elongated instances. */
+std::vector<int> spaceCurveOrder(const PointCloud &cloud, CurveKind kind)
+{
+    int n = cloud.size(), dims = cloud.dims(), i, d;
+    std::vector<int> perm(n);
+
+    for (i = 0; i < n; i++)
+    {
+        perm[i] = i;
+    }
+
+    if (kind == CURVE_NONE || n == 0)
+    {
+        return perm;
+    }
+
+    const double *axes[3] = { cloud.xs(), cloud.ys(), cloud.zs() };
+    double lo[3], hi[3], span = 0.0;
+
+    for (d = 0; d < dims; d++)
+    {
+        lo[d] = *std::min_element(axes[d], axes[d] + n);
+        hi[d] = *std::max_element(axes[d], axes[d] + n);
+        span = std::max(span, hi[d] - lo[d]);
+    }
+
+    std::vector<std::pair<uint64_t, int> > keyed(n);
+    for (i = 0; i < n; i++)
+    {
+        uint32_t cell[3];
+        for (d = 0; d < dims; d++)
+        {
+            cell[d] = quantize(axes[d][i], lo[d], span);
+        }
+        keyed[i].first = kind == CURVE_HILBERT ? hilbertKey(cell, dims)
+            : mortonKey(cell, dims);
+        keyed[i].second = i;
+    }
+
+    /* Ties (cities in the same cell) keep their input order. */
+    std::sort(keyed.begin(), keyed.end());
+    for (i = 0; i < n; i++)
+    {
+        perm[i] = keyed[i].second;
+    }
+
+    return perm;
+}
+
+/*! Copies the points of CLOUD in the order PERM, keeping a planar cloud
+    planar. */
+PointCloud permutePointCloud(const PointCloud &cloud,
+    const std::vector<int> &perm)
+{
+    if (cloud.dims() == 2)
+    {
+        std::vector<Point2> points;
+        points.reserve(perm.size());
+        for (int i : perm)
+        {
+            points.push_back(Point2(cloud.getX(i), cloud.getY(i)));
+        }
+        return PointCloud(points);
+    }
+
+    std::vector<Point> points;
+    points.reserve(perm.size());
+    for (int i : perm)
+    {
+        points.push_back(cloud.getPoint(i));
+    }
+    return PointCloud(points);
+}
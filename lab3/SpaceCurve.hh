@@ -0,0 +1,36 @@
+#ifndef _SPACE_CURVE_H_
+#define _SPACE_CURVE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PointCloud.hh"
+
+// Bits per coordinate when quantizing points onto a curve; three coordinates
+// of this width fill a 64-bit key.
+#define SPACE_CURVE_BITS 21
+
+// Space-filling curves along which cities can be renumbered.  Cities that
+// are close in space get close indices, so a tour through nearby cities
+// reads nearby matrix rows and coordinates.
+enum CurveKind {
+    CURVE_NONE,         // keep input order
+    CURVE_HILBERT,
+    CURVE_MORTON
+};
+
+bool parseCurveKind(const std::string &name, CurveKind &kind);
+
+uint64_t hilbertKey(uint32_t coords[], int dims);
+uint64_t mortonKey(const uint32_t coords[], int dims);
+
+// The cities of CLOUD sorted along curve KIND: entry k is the input index of
+// the city numbered k afterwards.  CURVE_NONE yields the identity.
+std::vector<int> spaceCurveOrder(const PointCloud &cloud, CurveKind kind);
+
+// An owning copy of CLOUD whose point k is point PERM[k] of CLOUD.
+PointCloud permutePointCloud(const PointCloud &cloud,
+    const std::vector<int> &perm);
+
+#endif /* End of include guard for SpaceCurve.hh */
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include "WindowPolish.hh"
+
+// A window's new order must be shorter by at least this fraction, so that
+// rounding cannot keep a sweep going forever.
+#define POLISH_EPSILON 1e-12
+
+PolishStats::PolishStats()
+    : initial_length(0.0), final_length(0.0), windows(0), improved(0),
+      passes(0), seconds(0.0)
+{
+    // no-op
+}
+
+// One thread's scratch space for re-sequencing windows of K cities.
+struct WindowSolver {
+    int k, m;                       // window size, and cities free to move
+    std::vector<double> d;          // k x k edge lengths within the window
+    std::vector<double> cost;       // cost[S * m + j], see solve()
+    std::vector<uint8_t> parent;    // city before j on that path
+    std::vector<int> cities;        // the window's cities in tour order
+
+    WindowSolver(int k);
+    bool solve(const DistanceStore &dist, std::vector<int> &tour, int start);
+};
+
+WindowSolver::WindowSolver(int k)
+    : k(k), m(k - 2), d(k * k), cost(((std::size_t) 1 << m) * m),
+      parent(cost.size()), cities(k)
+{
+    // no-op
+}
+
+/*! Re-sequences the K cities of TOUR from position START on, wrapping
+    around, so that the path from the first to the last is as short as
+    possible.  Returns true if the order changed.
+
+    With the first city as a, the last as b and bit i of S standing for
+    interior city i + 1, cost(S, j) is the length of the shortest path from
+    a through exactly the cities of S, ending at j in S:
+
+        cost({j}, j) = d(a, j)
+        cost(S, j)   = min over i in S - {j} of cost(S - {j}, i) + d(i, j)
+
+    and the best window is the minimum over j of cost(all, j) + d(j, b).
+
+    Complexity: O(2^k k^2). */
+bool WindowSolver::solve(const DistanceStore &dist, std::vector<int> &tour,
+    int start)
+{
+    int n = tour.size(), i, j;
+    unsigned full = (1u << m) - 1, s;
+    double current = 0.0;
+
+    for (i = 0; i < k; i++)
+    {
+        cities[i] = tour[(start + i) % n];
+    }
+    for (i = 0; i < k; i++)
+    {
+        for (j = 0; j < k; j++)
+        {
+            d[i * k + j] = i == j ? 0.0 : dist.distance(cities[i], cities[j]);
+        }
+    }
+    for (i = 0; i + 1 < k; i++)
+    {
+        current += d[i * k + i + 1];
+    }
+
+    /* Subsets only grow, so every S - {j} is filled before S. */
+    for (s = 1; s <= full; s++)
+    {
+        for (j = 0; j < m; j++)
+        {
+            if (!(s >> j & 1))
+            {
+                continue;
+            }
+
+            unsigned rest = s & ~(1u << j);
+            double *entry = &cost[(std::size_t) s * m + j];
+
+            if (rest == 0)
+            {
+                *entry = d[j + 1];
+                parent[(std::size_t) s * m + j] = UINT8_MAX;
+                continue;
+            }
+
+            double best = std::numeric_limits<double>::infinity();
+            int from = 0;
+            const double *prev = &cost[(std::size_t) rest * m];
+            for (i = 0; i < m; i++)
+            {
+                if (rest >> i & 1)
+                {
+                    double c = prev[i] + d[(i + 1) * k + j + 1];
+                    if (c < best)
+                    {
+                        best = c;
+                        from = i;
+                    }
+                }
+            }
+            *entry = best;
+            parent[(std::size_t) s * m + j] = from;
+        }
+    }
+
+    double best = std::numeric_limits<double>::infinity();
+    int last = 0;
+    for (j = 0; j < m; j++)
+    {
+        double c = cost[(std::size_t) full * m + j] + d[(j + 1) * k + k - 1];
+        if (c < best)
+        {
+            best = c;
+            last = j;
+        }
+    }
+
+    if (!(best < current * (1.0 - POLISH_EPSILON)))
+    {
+        return false;
+    }
+
+    /* Walk the parents back from the last interior city. */
+    for (s = full, i = m; i > 0; i--)
+    {
+        tour[(start + i) % n] = cities[last + 1];
+        int from = parent[(std::size_t) s * m + last];
+        s &= ~(1u << last);
+        last = from;
+    }
+
+    return true;
+}
+
+/*! Polishes TOUR with windows of K cities.
+
+    Windows starting K - 1 positions apart share only their end cities,
+    which stay in place, so each sweep is split into K - 1 phases, one per
+    starting offset, and the windows of a phase are claimed by threads from
+    a shared counter.  Sweeps repeat until a whole sweep changes nothing.
+
+    Complexity: O(n 2^k k^2) per sweep. */
+double polishTour(const DistanceStore &dist, std::vector<int> &tour, int k,
+    int num_threads, PolishStats *stats)
+{
+    auto started = std::chrono::steady_clock::now();
+    int n = tour.size();
+    PolishStats local;
+
+    if (stats == nullptr)
+    {
+        stats = &local;
+    }
+    stats->initial_length = dist.tourLength(tour);
+
+    k = std::min(k, n);
+    assert(k <= POLISH_MAX_WINDOW);
+    num_threads = std::max(1, num_threads);
+
+    bool changed = n > 3 && k > 3;
+    std::vector<WindowSolver> solvers;
+    if (changed)
+    {
+        solvers.assign(num_threads, WindowSolver(k));
+    }
+
+    while (changed)
+    {
+        changed = false;
+        stats->passes++;
+
+        for (int offset = 0; offset < k - 1; offset++)
+        {
+            int num_windows = n / (k - 1);
+            int threads = std::min(num_threads, num_windows);
+            std::atomic<int> next_window(0);
+            std::atomic<long long> improved(0);
+            std::vector<std::thread> workers;
+            int t;
+
+            auto work = [&](int id) {
+                int w;
+
+                while ((w = next_window++) < num_windows)
+                {
+                    if (solvers[id].solve(dist, tour, offset + w * (k - 1)))
+                    {
+                        improved++;
+                    }
+                }
+            };
+
+            for (t = 1; t < threads; t++)
+            {
+                workers.push_back(std::thread(work, t));
+            }
+            work(0);
+
+            for (t = 0; t < (int) workers.size(); t++)
+            {
+                workers[t].join();
+            }
+
+            stats->windows += num_windows;
+            stats->improved += improved;
+            changed = changed || improved > 0;
+        }
+    }
+
+    stats->final_length = dist.tourLength(tour);
+    stats->seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - started).count();
+
+    return stats->final_length;
+}
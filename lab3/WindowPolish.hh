@@ -0,0 +1,32 @@
+#ifndef _WINDOW_POLISH_H_
+#define _WINDOW_POLISH_H_
+
+#include <vector>
+
+#include "DistanceStore.hh"
+
+// Longest window polishTour() re-sequences; its table holds
+// 2^(k - 2) * (k - 2) partial path lengths per thread.
+#define POLISH_MAX_WINDOW 16
+
+// What a polishing run did.
+struct PolishStats {
+    double initial_length;      // tour length before polishing
+    double final_length;        // and after
+    long long windows;          // windows solved
+    long long improved;         // windows whose order changed
+    int passes;                 // sweeps over every window position
+    double seconds;             // wall-clock time spent
+
+    PolishStats();
+};
+
+// Shortens the cyclic TOUR through the cities of DIST by re-sequencing every
+// run of K consecutive cities optimally while keeping its first and last city
+// in place, sweeping until no window improves.  Windows that share no cities
+// but their ends are solved in parallel on NUM_THREADS threads.  Returns the
+// new tour length; STATS, if not null, receives the details.
+double polishTour(const DistanceStore &dist, std::vector<int> &tour, int k,
+    int num_threads, PolishStats *stats = nullptr);
+
+#endif /* End of include guard for WindowPolish.hh */
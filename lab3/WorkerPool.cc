@@ -0,0 +1,113 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "WorkerPool.hh"
+
+/*! Parses a schedule given on the command line: static, chunked or
+    chunked:N, where N, the number of items per chunk, goes to CHUNK.
+    Returns false if NAME is not recognized. */
+bool parseSchedule(const char *name, Schedule &schedule, int &chunk)
+{
+    if (strcmp(name, "static") == 0)
+    {
+        schedule = SCHEDULE_STATIC;
+    }
+    else if (strncmp(name, "chunked", 7) == 0)
+    {
+        schedule = SCHEDULE_CHUNKED;
+        if (name[7] == ':')
+        {
+            chunk = atoi(name + 8);
+            if (chunk <= 0)
+            {
+                return false;
+            }
+        }
+        else if (name[7] != '\0')
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/*! Starts NUM_THREADS - 1 helper threads; the caller of run() is the last
+    one. */
+WorkerPool::WorkerPool(int num_threads)
+    : job(nullptr), posted(0), running(0), stopping(false)
+{
+    for (int t = 1; t < num_threads; t++)
+    {
+        workers.push_back(std::thread(&WorkerPool::serve, this, t));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &t : workers)
+    {
+        t.join();
+    }
+}
+
+/*! A helper thread's loop: waits for each job, runs its share as thread
+    ID, and tells run() when it is the last to finish. */
+void WorkerPool::serve(int id)
+{
+    long long seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true)
+    {
+        wake.wait(guard, [&]() { return stopping || posted != seen; });
+        if (stopping)
+        {
+            return;
+        }
+        seen = posted;
+
+        const std::function<void(int)> &work = *job;
+        guard.unlock();
+        work(id);
+        guard.lock();
+
+        if (--running == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+/*! Posts WORK to the helpers, runs WORK(0) here and waits for the rest. */
+void WorkerPool::run(const std::function<void(int)> &work)
+{
+    if (workers.empty())
+    {
+        work(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &work;
+        running = workers.size();
+        posted++;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&]() { return running == 0; });
+}
@@ -0,0 +1,99 @@
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// How WorkerPool::forRange() splits a range among the threads.
+enum Schedule {
+    SCHEDULE_STATIC,            // one contiguous share per thread, fixed up front
+    SCHEDULE_CHUNKED            // chunks claimed from a shared counter
+};
+
+bool parseSchedule(const char *name, Schedule &schedule, int &chunk);
+
+// A fixed set of threads that run one job at a time, for work that is split
+// up many times per second, such as each generation of the genetic
+// algorithm.  The threads are started once and sleep between jobs, so a job
+// costs a wake-up instead of a thread creation.  The calling thread takes
+// part in every job as thread 0.
+class WorkerPool {
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;       // a job was posted, or stopping
+    std::condition_variable done;       // the last helper finished a job
+    const std::function<void(int)> *job;
+    long long posted;                   // jobs posted so far
+    int running;                        // helpers still on the current job
+    bool stopping;
+
+    void serve(int id);
+
+public:
+    explicit WorkerPool(int num_threads);
+    ~WorkerPool();
+
+    int size() const { return (int) workers.size() + 1; }
+
+    // Runs WORK(id) once for every thread id 0 .. size() - 1 and returns
+    // when all of them have returned.
+    void run(const std::function<void(int)> &work);
+
+    // Calls BODY(from, to, id) on thread ID for consecutive runs [from, to)
+    // that together cover [BEGIN, END) once.  The range is cut into chunks of
+    // CHUNK items: SCHEDULE_STATIC gives each thread an equal run of whole
+    // chunks, SCHEDULE_CHUNKED lets threads claim one chunk at a time.
+    template<class Body>
+    void forRange(int begin, int end, Schedule schedule, int chunk, Body body);
+};
+
+template<class Body>
+void WorkerPool::forRange(int begin, int end, Schedule schedule, int chunk,
+    Body body)
+{
+    int threads = size();
+    long long num_chunks = (std::max(end - begin, 0) + chunk - 1) / chunk;
+    std::atomic<int> next(begin);
+
+    if (num_chunks == 0)
+    {
+        return;
+    }
+    if (threads == 1 || num_chunks == 1)
+    {
+        body(begin, end, 0);
+        return;
+    }
+
+    /* run() takes a std::function, which would allocate to hold a lambda
+       capturing all of this; one capturing only SHARE fits inside it. */
+    auto share = [&](int id) {
+        if (schedule == SCHEDULE_STATIC)
+        {
+            int from = begin + (int) (num_chunks * id / threads) * chunk;
+            int to = std::min(end,
+                begin + (int) (num_chunks * (id + 1) / threads) * chunk);
+            if (from < to)
+            {
+                body(from, to, id);
+            }
+            return;
+        }
+
+        int from;
+        while ((from = next.fetch_add(chunk)) < end)
+        {
+            body(from, std::min(end, from + chunk), id);
+        }
+    };
+    run([&share](int id) { share(id); });
+}
+
+#endif /* End of include guard for WorkerPool.hh */
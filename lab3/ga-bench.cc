@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+#include "PointIO.hh"
+#include "tsp-ga.hh"
+
+/* Measures how the genetic algorithm scales with threads: generations per
+   second with 1, 2, 4, ... up to N threads evaluating and breeding genomes,
+   under the static and the chunked schedule. */
+
+// Each measurement runs whole GA runs for at least this many seconds.
+#define MIN_SECONDS 1.0
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options]" << std::endl
+        << "where options are" << std::endl
+        << "\t-i, --input=FILE\tcities in the test-N.txt format (default: uniformly random points)" << std::endl
+        << "\t-n, --random=N\tnumber of random points (default 500)" << std::endl
+        << "\t-d, --distances=KIND\tdistance store (default dense)" << std::endl
+        << "\t-p, --population=N\tGA population size (default 2000)" << std::endl
+        << "\t-g, --generations=N\tgenerations per GA run (default 5)" << std::endl
+        << "\t-t, --threads=N\tlargest number of threads to try (default: every hardware thread)" << std::endl
+        << "\t-c, --chunk=N\tgenomes per chunk for the chunked schedule (default " << GA_DEFAULT_CHUNK << ")" << std::endl;
+    exit(1);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Returns the generations per second of GA runs under OPTS, all from its
+    seed, repeated for at least MIN_SECONDS. */
+static double generationsPerSecond(const DistanceStore &dist,
+    const GAOptions &opts)
+{
+    long long generations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed;
+
+    do
+    {
+        findAShortPath(dist, opts);
+        generations += opts.num_generations;
+    } while ((elapsed = secondsSince(start)) < MIN_SECONDS);
+
+    return generations / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "input", required_argument, nullptr, 'i' },
+        { "random", required_argument, nullptr, 'n' },
+        { "distances", required_argument, nullptr, 'd' },
+        { "population", required_argument, nullptr, 'p' },
+        { "generations", required_argument, nullptr, 'g' },
+        { "threads", required_argument, nullptr, 't' },
+        { "chunk", required_argument, nullptr, 'c' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    const char *input_path = nullptr;
+    int num_random = 500;
+    int max_threads = std::max(1, (int) std::thread::hardware_concurrency());
+    DistanceOptions distance_opts;
+    GAOptions ga_opts;
+    int opt, t;
+
+    distance_opts.kind = DISTANCES_DENSE;
+    ga_opts.population_size = 2000;
+    ga_opts.num_generations = 5;
+    ga_opts.progress = nullptr;
+
+    while ((opt = getopt_long(argc, argv, "i:n:d:p:g:t:c:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            input_path = optarg;
+            break;
+
+        case 'n':
+            num_random = atoi(optarg);
+            if (num_random <= 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'd':
+            if (!parseDistanceKind(optarg, distance_opts.kind))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'p':
+            ga_opts.population_size = atoi(optarg);
+            if (ga_opts.population_size < 8)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'g':
+            ga_opts.num_generations = atoi(optarg);
+            if (ga_opts.num_generations <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 't':
+            max_threads = atoi(optarg);
+            if (max_threads <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'c':
+            ga_opts.chunk = atoi(optarg);
+            if (ga_opts.chunk <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    std::vector<Point> points;
+    if (input_path != nullptr)
+    {
+        std::string error;
+        if (!readPoints(input_path, points, 1, error))
+        {
+            std::cerr << input_path << ": " << error << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> coord(0.0, 1000.0);
+        for (int i = 0; i < num_random; i++)
+        {
+            points.push_back(Point(coord(rng), coord(rng), 0.0));
+        }
+    }
+
+    PointCloud cloud = buildPointCloud(points);
+    std::unique_ptr<DistanceStore> dist = makeDistanceStore(distance_opts, cloud);
+
+    ga_opts.keep_population = std::max(2, ga_opts.population_size / 4);
+    ga_opts.num_mutations = ga_opts.population_size;
+
+    std::vector<int> thread_counts;
+    for (t = 1; t < max_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::cout << cloud.size() << " cities, " << ga_opts.population_size
+        << " genomes, " << std::thread::hardware_concurrency()
+        << " hardware threads" << std::endl
+        << std::fixed << std::setprecision(2)
+        << std::setw(8) << "threads"
+        << std::setw(12) << "static" << std::setw(9) << "speedup"
+        << std::setw(12) << "chunked" << std::setw(9) << "speedup"
+        << "   (generations/s)" << std::endl;
+
+    double base[2] = { 0.0, 0.0 };
+    for (int threads : thread_counts)
+    {
+        std::cout << std::setw(8) << threads;
+
+        for (int s = 0; s < 2; s++)
+        {
+            ga_opts.num_threads = threads;
+            ga_opts.schedule = s == 0 ? SCHEDULE_STATIC : SCHEDULE_CHUNKED;
+
+            double rate = generationsPerSecond(*dist, ga_opts);
+            if (threads == 1)
+            {
+                base[s] = rate;
+            }
+            std::cout << std::setw(12) << rate
+                << std::setw(8) << rate / base[s] << "x";
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
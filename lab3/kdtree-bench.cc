@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KDTree.hh"
+#include "PointCloud.hh"
+
+/* Compares k-d tree neighbor queries against brute force on the lab's
+   test-N.txt instances and on random instances of chosen sizes. */
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options] [test-N.txt ...]" << std::endl
+        << "where options are" << std::endl
+        << "\t-k, --neighbors=K\tneighbors per query (default 8)" << std::endl
+        << "\t-n, --random=N\talso run on N uniformly random points (repeatable)" << std::endl
+        << "\t-t, --threads=N\tthreads for the batched tree queries" << std::endl;
+    exit(1);
+}
+
+/*! Reads an instance in the test-N.txt format from PATH into POINTS. */
+static bool readInstance(const char *path, std::vector<Point> &points)
+{
+    std::ifstream in(path);
+    int num_points, i;
+    double x, y, z;
+
+    if (!(in >> num_points))
+    {
+        return false;
+    }
+
+    points.clear();
+    for (i = 0; i < num_points && in >> x >> y >> z; i++)
+    {
+        points.push_back(Point(x, y, z));
+    }
+
+    return i == num_points;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Brute-force neighbor lists: one row of distances per city, then a
+    partial sort. */
+static std::vector<int> bruteKNearest(const PointCloud &cloud, int k)
+{
+    int n = cloud.size(), i, j;
+    std::vector<int> result((std::size_t) n * k);
+    std::vector<double> row(n);
+    std::vector<int> idx(n);
+
+    for (i = 0; i < n; i++)
+    {
+        cloud.distancesFrom(i, row.data());
+        row[i] = 1e300;
+        for (j = 0; j < n; j++)
+        {
+            idx[j] = j;
+        }
+        std::partial_sort(idx.begin(), idx.begin() + k, idx.end(),
+            [&](int a, int b) { return row[a] < row[b]; });
+        std::copy(idx.begin(), idx.begin() + k, result.begin() + (std::size_t) i * k);
+    }
+
+    return result;
+}
+
+/*! Runs and prints one row of the comparison for instance NAME. */
+static void benchmark(const std::string &name, const std::vector<Point> &points,
+    int k, int num_threads)
+{
+    PointCloud cloud = buildPointCloud(points);
+    int n = cloud.size(), i, j;
+    bool same = true;
+
+    k = std::min(k, n - 1);
+
+    auto start = std::chrono::steady_clock::now();
+    KDTree tree(cloud);
+    double build_time = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int> serial = tree.allKNearest(k, 1);
+    double serial_time = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int> parallel = tree.allKNearest(k, num_threads);
+    double parallel_time = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int> brute = bruteKNearest(cloud, k);
+    double brute_time = secondsSince(start);
+
+    /* Ties may be ordered differently, so compare distances, not indices. */
+    for (i = 0; i < n && same; i++)
+    {
+        for (j = 0; j < k; j++)
+        {
+            std::size_t e = (std::size_t) i * k + j;
+            if (cloud.distance(i, parallel[e]) != cloud.distance(i, brute[e]))
+            {
+                same = false;
+            }
+        }
+    }
+
+    /* Radius queries out to each city's k-th neighbor. */
+    long long found = 0;
+    std::vector<int> within;
+    start = std::chrono::steady_clock::now();
+    for (i = 0; i < n; i++)
+    {
+        Point p = cloud.getPoint(i);
+        tree.radius(p, cloud.distance(i, parallel[(std::size_t) i * k + k - 1]),
+            within);
+        found += within.size();
+    }
+    double radius_time = secondsSince(start);
+
+    std::cout << std::setw(16) << name << std::setw(9) << n
+        << std::setw(12) << build_time * 1e3
+        << std::setw(12) << serial_time * 1e3
+        << std::setw(12) << parallel_time * 1e3
+        << std::setw(12) << brute_time * 1e3
+        << std::setw(10) << brute_time / parallel_time
+        << std::setw(12) << radius_time * 1e3
+        << std::setw(8) << (same ? "ok" : "DIFF") << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "neighbors", required_argument, nullptr, 'k' },
+        { "random", required_argument, nullptr, 'n' },
+        { "threads", required_argument, nullptr, 't' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<int> random_sizes;
+    int k = 8;
+    int num_threads = std::max(1, (int) std::thread::hardware_concurrency());
+    int opt, i;
+
+    while ((opt = getopt_long(argc, argv, "k:n:t:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'k':
+            k = atoi(optarg);
+            if (k <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'n':
+            random_sizes.push_back(atoi(optarg));
+            if (random_sizes.back() <= 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 't':
+            num_threads = atoi(optarg);
+            if (num_threads <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+        << std::setw(16) << "instance" << std::setw(9) << "n"
+        << std::setw(12) << "build ms" << std::setw(12) << "tree ms"
+        << std::setw(12) << "tree||" << std::setw(12) << "brute ms"
+        << std::setw(10) << "speedup" << std::setw(12) << "radius ms"
+        << std::setw(8) << "check" << std::endl;
+
+    for (i = optind; i < argc; i++)
+    {
+        std::vector<Point> points;
+        if (!readInstance(argv[i], points) || points.size() < 2)
+        {
+            std::cerr << "Cannot read instance " << argv[i] << std::endl;
+            return 1;
+        }
+        benchmark(argv[i], points, k, num_threads);
+    }
+
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    for (int n : random_sizes)
+    {
+        std::vector<Point> points;
+        for (i = 0; i < n; i++)
+        {
+            points.push_back(Point(coord(gen), coord(gen), coord(gen)));
+        }
+        benchmark("random", points, k, num_threads);
+    }
+
+    return 0;
+}
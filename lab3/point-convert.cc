@@ -0,0 +1,100 @@
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CostMatrixFile.hh"
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+#include "PointFile.hh"
+#include "PointIO.hh"
+
+/* Converts a point set in the test-N.txt format into a binary point file,
+   or a cost matrix file of the distances between the points, that tsp and
+   tsp-ga can memory-map with -i. */
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options] input.txt output.bin"
+        << std::endl << "where options are" << std::endl
+        << "\t-f, --float\tstore single-precision coordinates (the file is widened to double when loaded, so it is not used in place)" << std::endl
+        << "\t-m, --costs=TYPE\twrite the n x n matrix of distances between the points instead, as float or int32 (rounded) costs" << std::endl
+        << "Input whose z coordinates are all 0 is stored as a planar file." << std::endl;
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "float", no_argument, nullptr, 'f' },
+        { "costs", required_argument, nullptr, 'm' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<Point> pts;
+    std::string error;
+    int precision = 8;
+    CostType cost_type = COSTS_FLOAT32;
+    bool costs = false;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "fm:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            precision = 4;
+            break;
+
+        case 'm':
+            if (!parseCostType(optarg, cost_type))
+            {
+                usage(argv[0]);
+            }
+            costs = true;
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        usage(argv[0]);
+    }
+
+    if (!readPoints(argv[optind], pts, 1, error))
+    {
+        std::cerr << argv[optind] << ": " << error << std::endl;
+        return 1;
+    }
+
+    PointCloud cloud = buildPointCloud(pts);
+    if (costs)
+    {
+        if (!writeCostMatrixFile(argv[optind + 1], EuclideanDistances(cloud),
+            cost_type, error))
+        {
+            std::cerr << argv[optind + 1] << ": " << error << std::endl;
+            return 1;
+        }
+
+        std::cout << "Wrote the " << cloud.size() << " x " << cloud.size()
+            << " " << (cost_type == COSTS_FLOAT32 ? "float" : "int32")
+            << " cost matrix to " << argv[optind + 1] << std::endl;
+        return 0;
+    }
+
+    if (!writePointFile(argv[optind + 1], cloud, precision, error))
+    {
+        std::cerr << argv[optind + 1] << ": " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << cloud.size() << " " << cloud.dims() << "D points ("
+        << precision * 8 << "-bit) to " << argv[optind + 1] << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "DistanceStore.hh"
+#include "PointCloud.hh"
+#include "SpaceCurve.hh"
+#include "tsp-ga.hh"
+
+/* Measures how renumbering the cities along a space-filling curve changes
+   the cost of evaluating tours: cache misses and time per edge for a
+   spatially coherent tour, and genetic algorithm generations per second. */
+
+static void usage(const char *prog_name)
+{
+    std::cerr << "Usage: " << prog_name << " [options] [test-N.txt ...]" << std::endl
+        << "where options are" << std::endl
+        << "\t-d, --distances=KIND\tdistance store to evaluate tours with (default matrix)" << std::endl
+        << "\t-n, --random=N\talso run on N uniformly random points (repeatable)" << std::endl
+        << "\t-p, --population=N\tGA population size (default 16)" << std::endl
+        << "\t-g, --generations=N\tGA generations to time, or 0 to skip the GA (default 3)" << std::endl;
+    exit(1);
+}
+
+// Counts hardware cache misses of this thread with perf_event_open().  When
+// the kernel or the sandbox does not allow it, available() is false.
+class CacheMissCounter {
+
+private:
+    int fd;
+
+public:
+    CacheMissCounter() {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~CacheMissCounter() {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    long long stop() {
+        long long count = 0;
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+        }
+        return count;
+    }
+};
+
+/*! Reads an instance in the test-N.txt format from PATH into POINTS. */
+static bool readInstance(const char *path, std::vector<Point> &points)
+{
+    std::ifstream in(path);
+    int num_points, i;
+    double x, y, z;
+
+    if (!(in >> num_points))
+    {
+        return false;
+    }
+
+    points.clear();
+    for (i = 0; i < num_points && in >> x >> y >> z; i++)
+    {
+        points.push_back(Point(x, y, z));
+    }
+
+    return i == num_points;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/*! Runs and prints one row of the comparison: instance NAME under numbering
+    CURVE.  TOUR visits the cities of the input numbering in a spatially
+    coherent order, as good tours do. */
+static void benchmark(const std::string &name, const PointCloud &input,
+    const std::vector<int> &tour, CurveKind curve, const char *curve_name,
+    const DistanceOptions &distance_opts, const GAOptions &ga_opts)
+{
+    std::vector<int> perm = spaceCurveOrder(input, curve);
+    PointCloud cloud = permutePointCloud(input, perm);
+    std::unique_ptr<DistanceStore> dist = makeDistanceStore(distance_opts, cloud);
+    int n = cloud.size(), i;
+
+    /* Express the same tour in the new numbering. */
+    std::vector<int> renumbered(n), order(n);
+    for (i = 0; i < n; i++)
+    {
+        renumbered[perm[i]] = i;
+    }
+    for (i = 0; i < n; i++)
+    {
+        order[i] = renumbered[tour[i]];
+    }
+
+    /* Evaluate the tour repeatedly, enough to touch about 50M edges. */
+    int reps = std::max(1, 50000000 / n);
+    double total = 0.0;
+    CacheMissCounter misses;
+
+    misses.start();
+    auto start = std::chrono::steady_clock::now();
+    for (i = 0; i < reps; i++)
+    {
+        total += dist->tourLength(order);
+    }
+    double eval_time = secondsSince(start);
+    long long miss_count = misses.stop();
+
+    /* A short GA run from a fixed seed. */
+    double ga_time = 0.0;
+    if (ga_opts.num_generations > 0)
+    {
+        start = std::chrono::steady_clock::now();
+        findAShortPath(*dist, ga_opts);
+        ga_time = secondsSince(start);
+    }
+
+    double edges = (double) reps * n;
+    std::cout << std::setw(16) << name << std::setw(9) << n
+        << std::setw(9) << curve_name
+        << std::setw(14) << total / reps
+        << std::setw(10) << eval_time / edges * 1e9;
+    if (misses.available())
+    {
+        std::cout << std::setw(14) << miss_count / edges;
+    }
+    else
+    {
+        std::cout << std::setw(14) << "n/a";
+    }
+    if (ga_opts.num_generations > 0)
+    {
+        std::cout << std::setw(10) << ga_opts.num_generations / ga_time;
+    }
+    else
+    {
+        std::cout << std::setw(10) << "-";
+    }
+    std::cout << std::endl;
+}
+
+/*! Runs every numbering on the instance POINTS. */
+static void benchmarkAll(const std::string &name,
+    const std::vector<Point> &points, const DistanceOptions &distance_opts,
+    const GAOptions &ga_opts)
+{
+    PointCloud input = buildPointCloud(points);
+
+    /* The Hilbert order itself is a reasonable tour; in the input numbering
+       its edges jump around memory. */
+    std::vector<int> tour = spaceCurveOrder(input, CURVE_HILBERT);
+
+    benchmark(name, input, tour, CURVE_NONE, "none", distance_opts, ga_opts);
+    benchmark(name, input, tour, CURVE_MORTON, "morton", distance_opts, ga_opts);
+    benchmark(name, input, tour, CURVE_HILBERT, "hilbert", distance_opts, ga_opts);
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        { "distances", required_argument, nullptr, 'd' },
+        { "random", required_argument, nullptr, 'n' },
+        { "population", required_argument, nullptr, 'p' },
+        { "generations", required_argument, nullptr, 'g' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    std::vector<int> random_sizes;
+    DistanceOptions distance_opts;
+    GAOptions ga_opts;
+    int opt, i;
+
+    distance_opts.kind = DISTANCES_MATRIX;
+    ga_opts.population_size = 16;
+    ga_opts.num_generations = 3;
+    ga_opts.progress = nullptr;
+
+    while ((opt = getopt_long(argc, argv, "d:n:p:g:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            if (!parseDistanceKind(optarg, distance_opts.kind))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'n':
+            random_sizes.push_back(atoi(optarg));
+            if (random_sizes.back() <= 1)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'p':
+            ga_opts.population_size = atoi(optarg);
+            if (ga_opts.population_size < 2)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'g':
+            ga_opts.num_generations = atoi(optarg);
+            if (ga_opts.num_generations < 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    ga_opts.keep_population = std::max(1, ga_opts.population_size / 4);
+    ga_opts.num_mutations = ga_opts.population_size;
+
+    std::cout << std::fixed << std::setprecision(3)
+        << std::setw(16) << "instance" << std::setw(9) << "n"
+        << std::setw(9) << "curve" << std::setw(14) << "tour length"
+        << std::setw(10) << "ns/edge" << std::setw(14) << "misses/edge"
+        << std::setw(10) << "gen/s" << std::endl;
+
+    for (i = optind; i < argc; i++)
+    {
+        std::vector<Point> points;
+        if (!readInstance(argv[i], points) || points.size() < 2)
+        {
+            std::cerr << "Cannot read instance " << argv[i] << std::endl;
+            return 1;
+        }
+        benchmarkAll(argv[i], points, distance_opts, ga_opts);
+    }
+
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0);
+    for (int n : random_sizes)
+    {
+        std::vector<Point> points;
+        for (i = 0; i < n; i++)
+        {
+            points.push_back(Point(coord(gen), coord(gen), coord(gen)));
+        }
+        benchmarkAll("random", points, distance_opts, ga_opts);
+    }
+
+    return 0;
+}
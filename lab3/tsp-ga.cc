@@ -1,25 +1,274 @@
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <utility>
 
 #include <cstdlib>
 
+#include "OneTreeBound.hh"
 #include "tsp-ga.hh"
 
-/*! Constructs an instance of TSPGenome with a random ordering of NUM_POINTS. */
-TSPGenome::TSPGenome(int num_points)
+// The parents of a genome bred by crosslink(), and where the first one's
+// genes end.
+struct Pairing {
+    int g1, g2;
+    int split;
+};
+
+// Copies of the best genomes of an island, on their way to another: the
+// cities of each in turn, and their lengths.
+struct Migrants {
+    std::vector<int> cities;
+    std::vector<double> lengths;
+};
+
+// Genomes on their way to one island of the island model.  Each batch is
+// tagged with the migration it was sent in, since a fast sender can post
+// the next one before the island has taken the last.  Batches are swapped
+// in and out rather than copied, so the same buffers go round and round.
+class Mailbox {
+
+private:
+    struct Batch {
+        int epoch;
+        Migrants migrants;
+    };
+
+    std::mutex lock;
+    std::condition_variable arrived;
+    std::vector<Batch> batches;
+
+public:
+    void post(int epoch, Migrants &emigrants);
+    bool take(int epoch, Migrants &immigrants, const std::atomic<bool> &stop);
+    void wake();
+};
+
+// What each island last reported, for the progress lines.
+struct IslandStats {
+    std::atomic<double> best;           // its shortest tour, or infinity
+    std::atomic<int> generation;        // the generation it is on, or 0
+    std::atomic<long long> immigrants;  // genomes it has taken in
+
+    IslandStats()
+        : best(std::numeric_limits<double>::infinity()), generation(0),
+          immigrants(0) {}
+};
+
+template<class Index>
+static TSPGenome evolve(const DistanceStore &dist, const GAOptions &opts);
+template<class Index>
+static TSPGenome findWithIslands(const DistanceStore &dist,
+    const GAOptions &opts);
+
+/*! Fills TOUR with a random ordering of its cities drawn from RNG.  The
+    Fisher-Yates shuffle is spelled out, since std::shuffle may draw
+    differently from one library to the next. */
+template<class Index>
+static void shuffleTour(TourSpan<Index> tour, RandomStream &rng)
 {
+    int n = tour.size();
     int i;
 
-    for (i = 0; i < num_points; i++)
+    for (i = 0; i < n; i++)
+    {
+        tour[i] = i;
+    }
+
+    for (i = n - 1; i > 0; i--)
     {
-        order.push_back(i);
+        std::swap(tour[i], tour[rng.below(i + 1)]);
     }
+}
+
+/*! Swaps two cities of TOUR at positions chosen by RNG.  A swap replaces at
+    most the four edges into and out of the two positions, so if LENGTH is
+    up to date, as DIRTY says, it is corrected by their change in length,
+    looked up in DIST, rather than recomputed.  Edges are taken in tour
+    direction, so this holds for asymmetric costs too. */
+template<class Index>
+static void swapCities(TourSpan<Index> tour, double &length, bool dirty,
+    RandomStream &rng, const DistanceStore &dist)
+{
+    int n = tour.size();
+    int i, j, e, k, num_edges;
+    i = j = 0;
 
-    random_shuffle(order.begin(), order.end());
+    while (i == j)
+    {
+        i = rng.below(n);
+        j = rng.below(n);
+    }
+
+    if (dirty)
+    {
+        std::swap(tour[i], tour[j]);
+        return;
+    }
+
+    /* The edges leaving positions I - 1, I, J - 1 and J, each once: when
+       I and J are neighbours, two of them are the same edge. */
+    int starts[4] = { (i + n - 1) % n, i, (j + n - 1) % n, j };
+    int edges[4];
+    num_edges = 0;
+    for (e = 0; e < 4; e++)
+    {
+        for (k = 0; k < num_edges && edges[k] != starts[e]; k++)
+        {
+            // no-op
+        }
+        if (k == num_edges)
+        {
+            edges[num_edges++] = starts[e];
+        }
+    }
+
+    for (e = 0; e < num_edges; e++)
+    {
+        length -= dist.distance(tour[edges[e]], tour[(edges[e] + 1) % n]);
+    }
+    std::swap(tour[i], tour[j]);
+    for (e = 0; e < num_edges; e++)
+    {
+        length += dist.distance(tour[edges[e]], tour[(edges[e] + 1) % n]);
+    }
+}
+
+/*! Crosses two tours G1 and G2 into CHILD, an ordering that derives from
+    both: G1's cities up to position SPLIT, then the others in G2's order.
+    CHOSEN has a flag per city, all clear, and is left that way. */
+template<class Index>
+static void crosslink(TourSpan<const Index> g1, TourSpan<const Index> g2,
+    int split, TourSpan<Index> child, std::vector<unsigned char> &chosen)
+{
+    int n = g1.size();
+    int j, out;
+
+    for (j = 0; j <= split; j++)
+    {
+        child[j] = g1[j];
+        chosen[g1[j]] = 1;
+    }
+
+    /* Put all points in G2 into the new ordering that weren't already
+       obtained from G1. */
+    out = split + 1;
+    for (j = 0; j < n; j++)
+    {
+        if (!chosen[g2[j]])
+        {
+            child[out++] = g2[j];
+        }
+    }
+
+    for (j = 0; j <= split; j++)
+    {
+        chosen[g1[j]] = 0;
+    }
+}
+
+/*! The N cities of TOUR as ints, for DistanceStore::tourLength(): 32-bit
+    tours are read in place, 16-bit ones widened into BUFFER. */
+static const int *cityNumbers(const uint32_t *tour, int n,
+    std::vector<int> &buffer)
+{
+    return reinterpret_cast<const int *>(tour);
+}
+
+static const int *cityNumbers(const uint16_t *tour, int n,
+    std::vector<int> &buffer)
+{
+    buffer.assign(tour, tour + n);
+    return buffer.data();
+}
+
+/*! Computes the circuit lengths of the dirty genomes among genomes BEGIN ..
+    END - 1 of ARENA from DIST; the others are already up to date.  If the
+    store has a batch kernel the dirty genomes are interleaved TOUR_BATCH
+    at a time, into a buffer kept per thread, and measured together; the
+    last batch is padded with copies of its last genome. */
+template<class Index>
+static void computeCircuitLengths(GenomeArena<Index> &arena, int begin,
+    int end, const DistanceStore &dist)
+{
+    static thread_local std::vector<int> batch;
+    int n = dist.size();
+    int members[TOUR_BATCH];
+    int b, t, k, count;
+
+    if (!dist.batchesTours())
+    {
+        for (b = begin; b < end; b++)
+        {
+            if (arena.isDirty(b))
+            {
+                arena.length(b) = dist.tourLength(
+                    cityNumbers(arena.tour(b).data(), n, batch), n);
+                arena.setDirty(b, false);
+            }
+        }
+        return;
+    }
+
+    batch.resize((std::size_t) n * TOUR_BATCH);
+    double lengths[TOUR_BATCH];
+
+    b = begin;
+    while (true)
+    {
+        /* Gather the next TOUR_BATCH dirty genomes. */
+        for (count = 0; count < TOUR_BATCH && b < end; b++)
+        {
+            if (arena.isDirty(b))
+            {
+                members[count++] = b;
+            }
+        }
+        if (count == 0)
+        {
+            break;
+        }
+
+        for (t = 0; t < TOUR_BATCH; t++)
+        {
+            TourSpan<Index> tour = arena.tour(members[std::min(t, count - 1)]);
+            for (k = 0; k < n; k++)
+            {
+                batch[k * TOUR_BATCH + t] = tour[k];
+            }
+        }
+
+        dist.tourLengths(batch.data(), n, lengths);
+
+        for (t = 0; t < count; t++)
+        {
+            arena.length(members[t]) = lengths[t];
+            arena.setDirty(members[t], false);
+        }
+    }
+}
+
+/*! Constructs an instance of TSPGenome with a random ordering of NUM_POINTS
+    drawn from RNG. */
+TSPGenome::TSPGenome(int num_points, RandomStream &rng)
+{
+    randomize(num_points, rng);
+}
+
+/*! Replaces the ordering with a random ordering of NUM_POINTS drawn from RNG,
+    reusing the storage of the old one. */
+void TSPGenome::randomize(int num_points, RandomStream &rng)
+{
+    order.resize(num_points);
+    shuffleTour(TourSpan<int>(order.data(), num_points), rng);
 
     circuit_length = 1e9;
+    dirty = true;
 }
 
 /*! Constructs an instance of TSPGenome with a specified ORDER. */
@@ -28,6 +277,17 @@ TSPGenome::TSPGenome(const std::vector<int> &order)
     this->order = order;
 
     circuit_length = 1e9;
+    dirty = true;
+}
+
+/*! Constructs an instance of TSPGenome with a specified ORDER whose length,
+    CIRCUIT_LENGTH, is already known. */
+TSPGenome::TSPGenome(const std::vector<int> &order, double circuit_length)
+{
+    this->order = order;
+
+    this->circuit_length = circuit_length;
+    dirty = false;
 }
 
 TSPGenome::~TSPGenome(void)
@@ -36,7 +296,7 @@ TSPGenome::~TSPGenome(void)
 }
 
 /*! Getters for the order and circuit lengths. */
-std::vector<int> TSPGenome::getOrder(void) const
+const std::vector<int> &TSPGenome::getOrder(void) const
 {
     return order;
 }
@@ -46,6 +306,13 @@ double TSPGenome::getCircuitLength(void) const
     return circuit_length;
 }
 
+/*! True if the order has changed in a way the circuit length does not
+    reflect, so it has to be computed again. */
+bool TSPGenome::isDirty(void) const
+{
+    return dirty;
+}
+
 /*! Computes the length of a circuit using the ORDER in this class on the passed
     POINTS vector. Stores the computed length in the CIRCUIT_LENGTH variable.
 
@@ -61,20 +328,612 @@ void TSPGenome::computeCircuitLength(const std::vector<Point> &points)
     }
 
     circuit_length += points[order[order.size() - 1]].distanceTo(points[order[0]]);
+    dirty = false;
     return;
 }
 
-/*! Randomly swaps two elements in the ORDER vector. */
-void TSPGenome::mutate(void)
+/*! Same as above, but takes the edge lengths from the distance store DIST,
+    which may be a precomputed table. */
+void TSPGenome::computeCircuitLength(const DistanceStore &dist)
 {
-    int i, j;
-    i = j = 0;
+    circuit_length = dist.tourLength(order);
+    dirty = false;
+}
 
-    while (i == j)
+/*! Randomly swaps two elements in the ORDER vector, chosen by RNG, keeping
+    an up-to-date circuit length current with the edge lengths in DIST. */
+void TSPGenome::mutate(RandomStream &rng, const DistanceStore &dist)
+{
+    swapCities(TourSpan<int>(order.data(), (int) order.size()),
+        circuit_length, dirty, rng, dist);
+}
+
+/*! Defaults match a small run: 100 genomes for 100 generations, keeping the
+    best 20 and applying 100 mutations per generation, reporting progress on
+    stdout, with no lower bound, a population of its own and one thread,
+    one island, and seed 1. */
+GAOptions::GAOptions()
+    : population_size(100), num_generations(100), keep_population(20),
+      num_mutations(100), progress(&std::cout), lower_bound(nullptr),
+      target_gap(0.0), storage(nullptr), num_threads(1),
+      schedule(SCHEDULE_STATIC), chunk(GA_DEFAULT_CHUNK), islands(1),
+      migration_interval(GA_DEFAULT_MIGRATION_INTERVAL), migrants(2),
+      migration(MIGRATION_RING), seed(1)
+{
+    // no-op
+}
+
+/*! The parent and child arenas in STORAGE for city numbers of type Index. */
+static GenomeArena<uint16_t> *arenasFor(GAStorage &storage, uint16_t)
+{
+    return storage.narrow;
+}
+
+static GenomeArena<uint32_t> *arenasFor(GAStorage &storage, uint32_t)
+{
+    return storage.wide;
+}
+
+// One population of the genetic algorithm, with the threads, random stream
+// and scratch space that breed it.  findAShortPath() runs one; the island
+// model runs one per island.  The genomes live in two arenas: the parents,
+// and the children being bred from them, which become the parents of the
+// next generation.  Positions 0 .. population_size - 1 name the genomes in
+// the order the algorithm sees them: the order sort() leaves them in, or,
+// after breed(), the kept genomes best first and then the new ones.
+template<class Index>
+class Population {
+
+private:
+    const DistanceStore &dist;
+    const GAOptions &opts;
+    RandomStream rng;
+    WorkerPool pool;
+    GenomeArena<Index> *parents;
+    GenomeArena<Index> *children;
+    std::vector<int> ranking;       // the genome at each position
+    std::vector<Pairing> pairings;
+    std::vector<std::vector<unsigned char> > chosen;  // crosslink() flags per thread
+    int eval_chunk;                 // genomes per chunk when evaluating
+    int breed_chunk;                // and when breeding
+
+    void resetRanking();
+
+public:
+    Population(const DistanceStore &dist, const GAOptions &opts,
+        GenomeArena<Index> *arenas, int num_threads, const RandomStream &rng);
+
+    double length(int position) const {
+        return parents->length(ranking[position]);
+    }
+    TSPGenome genome(int position) const;
+
+    void evaluate(int begin);
+    void initialize();
+    void sort();
+    void breed();
+
+    void emigrate(int count, Migrants &emigrants) const;
+    void immigrate(const Migrants &immigrants);
+};
+
+/*! Sets up a population of OPTS.population_size genomes over the cities of
+    DIST, stored in the two ARENAS, whose evaluation and breeding are
+    divided among NUM_THREADS threads as OPTS.schedule says.  Every random
+    choice is drawn from RNG on the thread that calls breed().  This is
+    where a run's memory is allocated; the generations allocate none. */
+template<class Index>
+Population<Index>::Population(const DistanceStore &dist, const GAOptions &opts,
+    GenomeArena<Index> *arenas, int num_threads, const RandomStream &rng)
+    : dist(dist), opts(opts), rng(rng),
+      pool(std::max(1, std::min(num_threads, opts.population_size))),
+      parents(&arenas[0]), children(&arenas[1]),
+      ranking(opts.population_size), pairings(opts.population_size),
+      chosen(pool.size(), std::vector<unsigned char>(dist.size(), 0))
+{
+    /* Batch kernels measure TOUR_BATCH genomes at a time, so evaluation
+       chunks hold whole batches. */
+    int batch = dist.batchesTours() ? TOUR_BATCH : 1;
+    eval_chunk = opts.schedule == SCHEDULE_CHUNKED
+        ? (opts.chunk + batch - 1) / batch * batch : batch;
+    breed_chunk = opts.schedule == SCHEDULE_CHUNKED ? opts.chunk : 1;
+
+    parents->reset(opts.population_size, dist.size());
+    children->reset(opts.population_size, dist.size());
+    resetRanking();
+}
+
+/*! Puts every genome at the position of its own number. */
+template<class Index>
+void Population<Index>::resetRanking()
+{
+    for (int i = 0; i < opts.population_size; i++)
+    {
+        ranking[i] = i;
+    }
+}
+
+/*! A copy of the genome at POSITION. */
+template<class Index>
+TSPGenome Population<Index>::genome(int position) const
+{
+    TourSpan<const Index> tour = parents->tour(ranking[position]);
+
+    return TSPGenome(std::vector<int>(tour.begin(), tour.end()),
+        length(position));
+}
+
+/*! Computes the circuit length of every dirty genome at position BEGIN or
+    later. */
+template<class Index>
+void Population<Index>::evaluate(int begin)
+{
+    pool.forRange(begin, opts.population_size, opts.schedule, eval_chunk,
+        [&](int from, int to, int id) {
+            computeCircuitLengths(*parents, from, to, dist);
+        });
+}
+
+/*! Create an initial population of random genomes and record their
+    fitnesses. */
+template<class Index>
+void Population<Index>::initialize()
+{
+    for (int i = 0; i < opts.population_size; i++)
+    {
+        shuffleTour(parents->tour(i), rng);
+        parents->setDirty(i, true);
+    }
+    resetRanking();
+    evaluate(0);
+}
+
+/*! Sort the population by fitness.  Only the positions move. */
+template<class Index>
+void Population<Index>::sort()
+{
+    const GenomeArena<Index> &genomes = *parents;
+
+    resetRanking();
+    std::sort(ranking.begin(), ranking.end(), [&](int g1, int g2) {
+        return genomes.length(g1) < genomes.length(g2);
+    });
+}
+
+/*! Runs one generation on a sorted population: copies the top
+    OPTS.keep_population genomes into the children's arena, fills the rest
+    of it with crosslinks between them, makes it the parents' arena,
+    mutates, and evaluates the genomes that changed.  The kept genomes come
+    in with their lengths known, and mutations keep those up to date, so
+    only the replacements are measured in full. */
+template<class Index>
+void Population<Index>::breed()
+{
+    int populationSize = opts.population_size;
+    int keepPopulation = opts.keep_population;
+    int i;
+
+    /* Replace all but the top KEEP_POPULATION genomes in the population,
+       choosing the parents of every replacement first. */
+    for (i = keepPopulation; i < populationSize; i++)
+    {
+        Pairing &p = pairings[i];
+        p.g1 = p.g2 = 0;
+        while (p.g1 == p.g2)
+        {
+            p.g1 = rng.below(keepPopulation);
+            p.g2 = rng.below(keepPopulation);
+        }
+        p.split = rng.below(dist.size());
+    }
+
+    for (i = 0; i < keepPopulation; i++)
+    {
+        children->copy(i, *parents, ranking[i]);
+    }
+
+    /* Breed each inferior genome from two superior ones.  The threads
+       read only the parents' arena and write disjoint children. */
+    const GenomeArena<Index> &genomes = *parents;
+    pool.forRange(keepPopulation, populationSize, opts.schedule,
+        breed_chunk, [&](int from, int to, int id) {
+            for (int k = from; k < to; k++)
+            {
+                const Pairing &p = pairings[k];
+                crosslink(genomes.tour(ranking[p.g1]),
+                    genomes.tour(ranking[p.g2]), p.split,
+                    children->tour(k), chosen[id]);
+                children->setDirty(k, true);
+            }
+        });
+
+    std::swap(parents, children);
+    resetRanking();
+
+    /* Apply the specified number of mutations to the population. */
+    for (i = 0; i < opts.num_mutations; i++)
+    {
+        int mut_idx = 1 + rng.below(populationSize - 1);
+        swapCities(parents->tour(mut_idx), parents->length(mut_idx),
+            parents->isDirty(mut_idx), rng, dist);
+    }
+
+    /* Measure the new genomes. */
+    evaluate(keepPopulation);
+}
+
+/*! Copies the COUNT best genomes of a sorted population into EMIGRANTS,
+    reusing its buffers. */
+template<class Index>
+void Population<Index>::emigrate(int count, Migrants &emigrants) const
+{
+    int n = dist.size();
+
+    emigrants.cities.resize((std::size_t) count * n);
+    emigrants.lengths.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        TourSpan<const Index> tour = parents->tour(ranking[i]);
+        std::copy(tour.begin(), tour.end(), emigrants.cities.begin() + i * n);
+        emigrants.lengths[i] = length(i);
+    }
+}
+
+/*! Puts IMMIGRANTS in place of the weakest kept genomes of a sorted
+    population, and sorts the kept genomes again. */
+template<class Index>
+void Population<Index>::immigrate(const Migrants &immigrants)
+{
+    int n = dist.size();
+    int count = immigrants.lengths.size();
+    int first = opts.keep_population - count;
+    const GenomeArena<Index> &genomes = *parents;
+
+    for (int i = 0; i < count; i++)
+    {
+        int g = ranking[first + i];
+        std::copy(immigrants.cities.begin() + i * n,
+            immigrants.cities.begin() + (i + 1) * n, parents->tour(g).begin());
+        parents->length(g) = immigrants.lengths[i];
+        parents->setDirty(g, false);
+    }
+
+    std::sort(ranking.begin(), ranking.begin() + opts.keep_population,
+        [&](int g1, int g2) {
+            return genomes.length(g1) < genomes.length(g2);
+        });
+}
+
+/*! Shares SHORTEST, the best tour so far, with the lower bound in OPTS, if
+    any, which steps better with it.  Returns the bound, or 0 if none is
+    known yet. */
+static double shareTour(const GAOptions &opts, double shortest)
+{
+    if (opts.lower_bound == nullptr)
+    {
+        return 0.0;
+    }
+
+    opts.lower_bound->offerTour(shortest);
+    return opts.lower_bound->bound();
+}
+
+/*! Returns true once SHORTEST is provably within the target gap of
+    optimal, given the lower BOUND. */
+static bool reachedTarget(const GAOptions &opts, double shortest, double bound)
+{
+    return bound > 0.0 && opts.target_gap > 0.0
+        && shortest - bound <= opts.target_gap * bound;
+}
+
+/*! Prints the progress line for generation GEN, whose best tour has length
+    SHORTEST, if a progress stream is set.  Island runs end it themselves. */
+static void printGeneration(const GAOptions &opts, int gen, double shortest,
+    double bound, bool end_line)
+{
+    std::ostream &out = *opts.progress;
+
+    out << "Generation " << gen << ": shortest path is " << shortest;
+    if (bound > 0.0)
+    {
+        out << ", lower bound " << bound << " (gap "
+            << 100.0 * std::max(0.0, shortest - bound) / bound << "%)";
+    }
+    if (end_line)
+    {
+        out << std::endl;
+    }
+}
+
+/*! Genetic algorithm for finding a short Hamiltonian cycle through the cities
+    of DIST.  With a lower bound in OPTS, progress reports include the gap
+    between the best tour and the bound, and the run ends early once that
+    gap is at most OPTS.target_gap.  If OPTS.storage is set, the genomes
+    live there, and the memory an earlier run left there is reused.  With
+    more than one island in OPTS, the island model runs instead.
+
+    Evaluating the genomes and breeding the replacements, the two O(n) steps
+    per genome, are divided among OPTS.num_threads threads as OPTS.schedule
+    says.  The random choices are all drawn beforehand on the calling
+    thread, from stream 0 of OPTS.seed, so a given seed gives the same
+    result with any number of threads.  Cities are numbered with 16 bits
+    where they fit, and with 32 otherwise. */
+TSPGenome findAShortPath(const DistanceStore &dist, const GAOptions &opts)
+{
+    if (dist.size() <= GA_NARROW_CITIES)
+    {
+        return evolve<uint16_t>(dist, opts);
+    }
+    return evolve<uint32_t>(dist, opts);
+}
+
+/*! findAShortPath() with cities numbered by Index. */
+template<class Index>
+static TSPGenome evolve(const DistanceStore &dist, const GAOptions &opts)
+{
+    if (opts.islands > 1)
+    {
+        return findWithIslands<Index>(dist, opts);
+    }
+
+    GAStorage own_storage;
+    Population<Index> population(dist, opts, arenasFor(opts.storage != nullptr
+        ? *opts.storage : own_storage, Index()), opts.num_threads,
+        RandomStream::stream(opts.seed, 0));
+    int gen;
+
+    population.initialize();
+
+    gen = 1;
+    while (gen <= opts.num_generations)
+    {
+        double shortest = population.length(0);
+        double bound = shareTour(opts, shortest);
+
+        /* Every 10 generations, print out the shortest distance found so far. */
+        if (gen % 10 == 0 && opts.progress != nullptr)
+        {
+            printGeneration(opts, gen, shortest, bound, true);
+        }
+
+        /* Stop once the best tour is provably close enough to optimal. */
+        if (reachedTarget(opts, shortest, bound))
+        {
+            if (opts.progress != nullptr)
+            {
+                *opts.progress << "Generation " << gen << ": within "
+                    << 100.0 * opts.target_gap << "% of the lower bound, stopping"
+                    << std::endl;
+            }
+            break;
+        }
+
+        population.sort();
+        population.breed();
+        gen++;
+    }
+
+    /* Return the fittest genome. */
+    return population.genome(0);
+}
+
+/*! Returns the island that island ISLAND of NUM_ISLANDS sends its emigrants
+    to in migration EPOCH of a run from SEED.  Random targets come from a
+    cyclic permutation drawn with Sattolo's algorithm from a generator
+    seeded with the run's seed and the epoch, so every island computes the
+    same one and each receives exactly one batch per migration. */
+static int migrationTarget(Migration migration, int island, int num_islands,
+    uint64_t seed, int epoch)
+{
+    if (migration == MIGRATION_RING)
+    {
+        return (island + 1) % num_islands;
+    }
+
+    std::vector<int> target(num_islands);
+    RandomStream rng(deriveSeed(seed, epoch));
+    int i;
+
+    for (i = 0; i < num_islands; i++)
+    {
+        target[i] = i;
+    }
+    for (i = num_islands - 1; i > 0; i--)
+    {
+        std::swap(target[i], target[rng.below(i)]);
+    }
+
+    return target[island];
+}
+
+/*! Hands EMIGRANTS, sent in migration EPOCH, to this mailbox's island,
+    leaving EMIGRANTS empty. */
+void Mailbox::post(int epoch, Migrants &emigrants)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        batches.push_back(Batch());
+        batches.back().epoch = epoch;
+        batches.back().migrants.cities.swap(emigrants.cities);
+        batches.back().migrants.lengths.swap(emigrants.lengths);
+    }
+    arrived.notify_one();
+}
+
+/*! Waits for the batch sent in migration EPOCH and swaps its genomes into
+    IMMIGRANTS.  Returns false without them if STOP is raised first. */
+bool Mailbox::take(int epoch, Migrants &immigrants,
+    const std::atomic<bool> &stop)
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (true)
+    {
+        for (std::size_t b = 0; b < batches.size(); b++)
+        {
+            if (batches[b].epoch == epoch)
+            {
+                immigrants.cities.swap(batches[b].migrants.cities);
+                immigrants.lengths.swap(batches[b].migrants.lengths);
+                batches.erase(batches.begin() + b);
+                return true;
+            }
+        }
+        if (stop.load())
+        {
+            return false;
+        }
+        arrived.wait(guard);
+    }
+}
+
+/*! Wakes the island if it is waiting, so it notices a stop. */
+void Mailbox::wake()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    arrived.notify_all();
+}
+
+/*! The island model: OPTS.islands populations, each of OPTS.population_size
+    genomes, evolve on threads of their own.  Every OPTS.migration_interval
+    generations each island sends copies of its OPTS.migrants best genomes
+    to another island, by ring or at random, and takes in the batch sent to
+    it at the migration before, in place of its weakest kept genomes.
+    Waiting for the previous batch rather than the current one lets islands
+    drift a whole interval apart before one has to wait.  Each mailbox has
+    one writer and one reader per migration, and its lock is held only to
+    hand over a batch.  Island 0 prints the progress lines, with each
+    island's best tour and generation.  Returns the best genome of any
+    island.
+
+    Island I draws from stream I of OPTS.seed, and a batch holds the
+    sender's genomes as they were at the migration it was sent in, however
+    far the islands have drifted apart, so a given seed gives the same
+    result every run unless a target gap ends it early. */
+template<class Index>
+static TSPGenome findWithIslands(const DistanceStore &dist,
+    const GAOptions &opts)
+{
+    int num_islands = opts.islands, i;
+    int interval = opts.migration_interval;
+    int migrants = std::max(0, std::min(opts.migrants, opts.keep_population - 1));
+    int island_threads = std::max(1, opts.num_threads / num_islands);
+
+    std::vector<GAStorage> storage(num_islands);
+    std::vector<Mailbox> mailboxes(num_islands);
+    std::vector<IslandStats> stats(num_islands);
+    std::vector<TSPGenome> best(num_islands, TSPGenome(std::vector<int>()));
+    std::atomic<bool> stop(false);
+
+    /* Ends every island early, waking any waiting for migrants. */
+    auto stopAll = [&]() {
+        stop = true;
+        for (Mailbox &m : mailboxes)
+        {
+            m.wake();
+        }
+    };
+
+    auto work = [&](int id) {
+        Population<Index> population(dist, opts,
+            arenasFor(storage[id], Index()), island_threads,
+            RandomStream::stream(opts.seed, id));
+        Migrants moving;
+        int gen;
+
+        population.initialize();
+
+        for (gen = 1; gen <= opts.num_generations && !stop.load(); gen++)
+        {
+            double shortest = population.length(0);
+            double bound = shareTour(opts, shortest);
+
+            stats[id].best = shortest;
+            stats[id].generation = gen;
+
+            /* Islands that have not reported yet are infinitely far off,
+               and are listed as starting. */
+            if (id == 0 && gen % 10 == 0 && opts.progress != nullptr)
+            {
+                double global = stats[0].best;
+                int k;
+                for (k = 1; k < num_islands; k++)
+                {
+                    global = std::min(global, stats[k].best.load());
+                }
+
+                printGeneration(opts, gen, global, bound, false);
+                for (k = 0; k < num_islands; k++)
+                {
+                    *opts.progress << (k == 0 ? "; islands: " : ", ");
+                    if (stats[k].generation.load() == 0)
+                    {
+                        *opts.progress << "starting";
+                        continue;
+                    }
+                    *opts.progress << stats[k].best.load() << " (generation "
+                        << stats[k].generation.load() << ", "
+                        << stats[k].immigrants.load() << " immigrants)";
+                }
+                *opts.progress << std::endl;
+            }
+
+            if (reachedTarget(opts, shortest, bound))
+            {
+                if (opts.progress != nullptr)
+                {
+                    *opts.progress << "Island " << id << ", generation " << gen
+                        << ": within " << 100.0 * opts.target_gap
+                        << "% of the lower bound, stopping" << std::endl;
+                }
+                stopAll();
+                break;
+            }
+
+            population.sort();
+
+            if (interval > 0 && migrants > 0 && gen % interval == 0)
+            {
+                int epoch = gen / interval;
+
+                population.emigrate(migrants, moving);
+                mailboxes[migrationTarget(opts.migration, id, num_islands,
+                    opts.seed, epoch)].post(epoch, moving);
+
+                if (epoch > 1 && mailboxes[id].take(epoch - 1, moving, stop))
+                {
+                    population.immigrate(moving);
+                    stats[id].immigrants += moving.lengths.size();
+                }
+            }
+
+            population.breed();
+        }
+
+        stats[id].best = population.length(0);
+        best[id] = population.genome(0);
+    };
+
+    std::vector<std::thread> workers;
+    for (i = 1; i < num_islands; i++)
+    {
+        workers.push_back(std::thread(work, i));
+    }
+    work(0);
+
+    for (i = 0; i < (int) workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    int fittest = 0;
+    for (i = 1; i < num_islands; i++)
     {
-        i = rand() % order.size();
-        j = rand() % order.size();
+        if (best[i].getCircuitLength() < best[fittest].getCircuitLength())
+        {
+            fittest = i;
+        }
     }
 
-    std::swap(order[i], order[j]);
+    return best[fittest];
 }
@@ -1,9 +1,32 @@
 #ifndef _TSP_GA_H_
 #define _TSP_GA_H_
 
+#include <iostream>
 #include <vector>
 
+#include "DistanceStore.hh"
+#include "GenomeArena.hh"
 #include "Point.hh"
+#include "RandomStream.hh"
+#include "WorkerPool.hh"
+
+// Genomes per chunk when the GA's threads claim work in chunks.
+#define GA_DEFAULT_CHUNK 32
+
+// Generations between migrations in the island model, unless given.
+#define GA_DEFAULT_MIGRATION_INTERVAL 50
+
+// Instances with up to this many cities keep their genomes as 16-bit city
+// numbers.
+#define GA_NARROW_CITIES 65536
+
+// Where each island of the island model sends its emigrants.
+enum Migration {
+    MIGRATION_RING,             // always to the next island
+    MIGRATION_RANDOM            // to another island chosen anew each time
+};
+
+class OneTreeBound;
 
 class TSPGenome
 {
@@ -11,22 +34,58 @@ class TSPGenome
 private:
     std::vector<int> order;
     double circuit_length;
+    bool dirty;                 // order changed since circuit_length was computed
 
 public:
     // Constructors
-    TSPGenome(int num_points);
+    TSPGenome(int num_points, RandomStream &rng);
     TSPGenome(const std::vector<int> &order);
+    TSPGenome(const std::vector<int> &order, double circuit_length);
 
     // Destructor
     ~TSPGenome(void);
 
     // Accessors
-    std::vector<int> getOrder(void) const;
+    const std::vector<int> &getOrder(void) const;
     double getCircuitLength(void) const;
+    bool isDirty(void) const;
 
+    void randomize(int num_points, RandomStream &rng);
     void computeCircuitLength(const std::vector<Point> &points);
-    void mutate(void);
+    void computeCircuitLength(const DistanceStore &dist);
+    void mutate(RandomStream &rng, const DistanceStore &dist);
+};
+
+// Where the genetic algorithm keeps its population: a parent and a child
+// arena of each index width, swapped every generation.  Passing the same
+// storage to run after run reuses its memory.
+struct GAStorage {
+    GenomeArena<uint16_t> narrow[2];    // up to GA_NARROW_CITIES cities
+    GenomeArena<uint32_t> wide[2];      // more than that
+};
+
+// Parameters of a genetic algorithm run.
+struct GAOptions {
+    int population_size;
+    int num_generations;
+    int keep_population;        // fittest genomes kept each generation
+    int num_mutations;          // mutations applied per generation
+    std::ostream *progress;     // where to report progress, or null
+    OneTreeBound *lower_bound;  // running bound to report the gap to, or null
+    double target_gap;          // stop once this close to the bound, or 0
+    GAStorage *storage;         // genome storage reused across runs, or null
+    int num_threads;            // threads evaluating and crossing genomes
+    Schedule schedule;          // how genomes are divided among them
+    int chunk;                  // genomes per chunk for SCHEDULE_CHUNKED
+    int islands;                // populations evolving side by side
+    int migration_interval;     // generations between migrations, or 0
+    int migrants;               // best genomes each island sends per migration
+    Migration migration;        // and where it sends them
+    uint64_t seed;              // all random choices follow from this
+
+    GAOptions();
 };
 
+TSPGenome findAShortPath(const DistanceStore &dist, const GAOptions &opts);
 
 #endif /* End of include guard for tsp-ga.hh */
@@ -1,33 +1,236 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <ctime>
 #include <cstdlib>
-#include <unordered_set>
+#include <cstring>
+#include <getopt.h>
+#include <thread>
 
 #include "tsp-ga.hh"
+#include "CostMatrixFile.hh"
+#include "DenseDistances.hh"
+#include "DistanceMatrix.hh"
+#include "KDTree.hh"
+#include "OneTreeBound.hh"
+#include "PointCloud.hh"
+#include "PointFile.hh"
+#include "PointIO.hh"
+#include "SpaceCurve.hh"
+#include "WindowPolish.hh"
 #include "print_vector.h"
 
-static TSPGenome findAShortPath(const std::vector<Point> &points,
-    int populationSize, int numGenerations, int keepPopulation,
-    int numMutations);
-static TSPGenome crosslink(const TSPGenome &g1, const TSPGenome &g2);
+// What a thread of the batch mode keeps from one instance to the next.
+struct BatchWorker {
+    PointCloud cloud;
+    std::unique_ptr<DistanceStore> dist;
+    GAStorage storage;
+};
+
+// The answer for one instance of a batch.
+struct BatchResult {
+    double length;
+    std::vector<int> order;
+};
+
 static void usage(const char *prog_name);
+template<class Table>
+static void assignTable(std::unique_ptr<DistanceStore> &dist,
+    const PointCloud &cloud);
+static void buildBatchStore(DistanceKind kind, BatchWorker &worker);
+static int solveBatch(const char *path, GAOptions ga_opts,
+    const DistanceOptions &distance_opts, int polish_window);
 
 static void usage(const char *prog_name)
 {
-    std::cerr << "Usage: " << prog_name << " population generations keep mutate"
+    std::cerr << "Usage: " << prog_name << " [options] population generations keep mutate"
         << std::endl << "where" << std::endl << "\tpopulation specifies the population size"
         << std::endl << "\tgenerations specifies how many generations to run the GA for" << std::endl
         << "\tkeep is a floating point in [0, 1] specifying the percent of the population to preserve from generation to generation" << std::endl
-        << "\tmutate is a non-negative floating point number specifying how many mutations to apply to each member of the population on average." << std::endl;
+        << "\tmutate is a non-negative floating point number specifying how many mutations to apply to each member of the population on average." << std::endl
+        << "and options are" << std::endl
+        << "\t-d, --distances=KIND\thow to look up distances: points (compute on demand), matrix (precomputed table of doubles), float (table of floats), int16 (table of 16-bit fixed-point values), lazy (rows computed on demand) or dense (full square table of floats, evaluated eight tours at a time)" << std::endl
+        << "\t-c, --cache-rows=N\tnumber of rows kept by the lazy distance store" << std::endl
+        << "\t-i, --input=FILE\tread the points from FILE (- for stdin) instead of prompting for them; FILE is either in the test-N.txt format or a binary point file, which is memory-mapped, or a binary cost matrix file, which is memory-mapped and used as the distances in place of -d and is not renumbered" << std::endl
+        << "\t-t, --threads=N\tnumber of threads used to read input, build distance tables, evaluate and breed genomes and polish the tour" << std::endl
+        << "\t-s, --schedule=KIND\thow genomes are divided among the threads: static (an equal share each; the default) or chunked (" << GA_DEFAULT_CHUNK << " at a time from a shared counter; chunked:N for N at a time)" << std::endl
+        << "\t-r, --renumber=CURVE\tnumber the cities along a hilbert (default) or morton curve so nearby cities share cache lines, or keep the input order with none; the tour is printed with the input numbering" << std::endl
+        << "\t-p, --polish=K\tafter the GA, re-sequence every run of K (4 to " << POLISH_MAX_WINDOW << ", about 10 to 14 is useful) consecutive cities of the best tour optimally, keeping its ends in place" << std::endl
+        << "\t-b, --lower-bound\tcompute the Held-Karp 1-tree lower bound on a separate thread and report the gap to it" << std::endl
+        << "\t-g, --target-gap=PERCENT\tend the GA once its best tour is within PERCENT of the lower bound (implies -b)" << std::endl
+        << "\t-I, --islands=K\trun K populations of the given size side by side, one thread each (sharing --threads among them), exchanging their best genomes from time to time" << std::endl
+        << "\t-M, --migrate=M\tgenerations between migrations in island mode (default " << GA_DEFAULT_MIGRATION_INTERVAL << "; 0 keeps the islands apart)" << std::endl
+        << "\t-E, --migrants=N\tbest genomes each island sends per migration (default 2)" << std::endl
+        << "\t-T, --topology=KIND\twhere migrants go: ring (to the next island; the default) or random (to a different island each time)" << std::endl
+        << "\t-S, --seed=N\tseed for every random choice; runs with the same seed and islands give the same tour on any number of threads (default: the time, which is printed)" << std::endl
+        << "\t-B, --batch=FILE\tsolve every instance in FILE (- for stdin), a sequence of sets in the test-N.txt format, on --threads threads at once; prints one line per instance in input order and the throughput on stderr; cities are not renumbered and KIND must be points, matrix, float, int16 or dense" << std::endl;
     exit(1);
 }
 
-int main(int argc, char const *argv[])
+int main(int argc, char *argv[])
 {
     using namespace std;
 
-    if (argc != 5)
+    static const struct option long_options[] = {
+        { "distances", required_argument, nullptr, 'd' },
+        { "cache-rows", required_argument, nullptr, 'c' },
+        { "input", required_argument, nullptr, 'i' },
+        { "threads", required_argument, nullptr, 't' },
+        { "renumber", required_argument, nullptr, 'r' },
+        { "polish", required_argument, nullptr, 'p' },
+        { "lower-bound", no_argument, nullptr, 'b' },
+        { "target-gap", required_argument, nullptr, 'g' },
+        { "batch", required_argument, nullptr, 'B' },
+        { "schedule", required_argument, nullptr, 's' },
+        { "islands", required_argument, nullptr, 'I' },
+        { "migrate", required_argument, nullptr, 'M' },
+        { "migrants", required_argument, nullptr, 'E' },
+        { "topology", required_argument, nullptr, 'T' },
+        { "seed", required_argument, nullptr, 'S' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    DistanceOptions distance_opts;
+    const char *input_path = nullptr;
+    const char *batch_path = nullptr;
+    CurveKind curve = CURVE_HILBERT;
+    int polish_window = 0;
+    bool lower_bound = false;
+    double target_gap = 0.0;
+    Schedule schedule = SCHEDULE_STATIC;
+    int chunk = GA_DEFAULT_CHUNK;
+    GAOptions island_opts;
+    uint64_t seed = time(nullptr);
+    int opt;
+
+    /* Read the options, checking that each is in-bounds. */
+    while ((opt = getopt_long(argc, argv, "d:c:i:t:r:p:bg:B:s:I:M:E:T:S:", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            if (!parseDistanceKind(optarg, distance_opts.kind))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'c':
+            distance_opts.cache_rows = atoi(optarg);
+            if (distance_opts.cache_rows <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'i':
+            input_path = optarg;
+            break;
+
+        case 't':
+            distance_opts.num_threads = atoi(optarg);
+            if (distance_opts.num_threads <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'r':
+            if (!parseCurveKind(optarg, curve))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'p':
+            polish_window = atoi(optarg);
+            if (polish_window < 4 || polish_window > POLISH_MAX_WINDOW)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'b':
+            lower_bound = true;
+            break;
+
+        case 'g':
+            target_gap = atof(optarg) / 100.0;
+            if (target_gap <= 0.0)
+            {
+                usage(argv[0]);
+            }
+            lower_bound = true;
+            break;
+
+        case 'B':
+            batch_path = optarg;
+            break;
+
+        case 's':
+            if (!parseSchedule(optarg, schedule, chunk))
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'I':
+            island_opts.islands = atoi(optarg);
+            if (island_opts.islands <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'M':
+            island_opts.migration_interval = atoi(optarg);
+            if (island_opts.migration_interval < 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'E':
+            island_opts.migrants = atoi(optarg);
+            if (island_opts.migrants <= 0)
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'T':
+            if (strcmp(optarg, "ring") == 0)
+            {
+                island_opts.migration = MIGRATION_RING;
+            }
+            else if (strcmp(optarg, "random") == 0)
+            {
+                island_opts.migration = MIGRATION_RANDOM;
+            }
+            else
+            {
+                usage(argv[0]);
+            }
+            break;
+
+        case 'S':
+        {
+            char *end;
+            seed = strtoull(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0')
+            {
+                usage(argv[0]);
+            }
+            break;
+        }
+
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (argc - optind != 4)
     {
         usage(argv[0]);
     }
@@ -36,160 +239,390 @@ int main(int argc, char const *argv[])
     double keep, mutate;
 
     /* Read the arguments, checking that each is in-bounds. */
-    population_size = atoi(argv[1]);
+    population_size = atoi(argv[optind]);
     if (population_size <= 0)
     {
         usage(argv[0]);
     }
 
-    num_generations = atoi(argv[2]);
+    num_generations = atoi(argv[optind + 1]);
     if (num_generations <= 0)
     {
         usage(argv[0]);
     }
 
-    keep = atof(argv[3]);
+    keep = atof(argv[optind + 2]);
     if (keep < 0.0 || keep > 1.0)
     {
         usage(argv[0]);
     }
 
-    mutate = atof(argv[4]);
+    mutate = atof(argv[optind + 3]);
     if (mutate < 0)
     {
         usage(argv[0]);
     }
 
-    /* Seed the random number generator. */
-    srand(time(nullptr));
+    if (batch_path != nullptr)
+    {
+        if (input_path != nullptr || lower_bound
+            || distance_opts.kind == DISTANCES_LAZY)
+        {
+            usage(argv[0]);
+        }
 
-    /* Prompt user for the number of points. */
-    int num_points, i;
-    double x, y, z;
+        GAOptions ga_opts;
+        ga_opts.population_size = population_size;
+        ga_opts.num_generations = num_generations;
+        ga_opts.keep_population = keep * population_size;
+        ga_opts.num_mutations = mutate * population_size;
+        ga_opts.progress = nullptr;
+        ga_opts.seed = seed;
 
-    cout << "How many points?" << endl;
-    cin >> num_points;
+        return solveBatch(batch_path, ga_opts, distance_opts, polish_window);
+    }
 
+    /* Prompt user for the number of points. */
     std::vector<Point> pts;
+    MappedPointFile mapped;
+    PointCloud cloud;
+    unique_ptr<DistanceStore> dist;
+    bool from_matrix = input_path != nullptr && isCostMatrixFile(input_path);
 
-    /* Read in the specified number of points from STDIN. */
-    for (i = 0; i < num_points; i++)
+    if (from_matrix)
     {
-        cout << "Point " << i << ":" << endl;
-        cin >> x >> y >> z;
-        pts.push_back(Point(x, y, z));
+        /* Look the costs up in the mapped matrix; there are no points. */
+        string error;
+        dist = openCostMatrixFile(input_path, error);
+        if (!dist)
+        {
+            cerr << input_path << ": " << error << endl;
+            return 1;
+        }
+    }
+    else if (input_path != nullptr && isPointFile(input_path))
+    {
+        /* Map a binary point file and use its coordinates in place. */
+        string error;
+        if (!mapped.open(input_path, error))
+        {
+            cerr << input_path << ": " << error << endl;
+            return 1;
+        }
+        cloud = mapped.cloud();
+    }
+    else
+    {
+        if (input_path != nullptr)
+        {
+            /* Bulk-load the text points without prompting. */
+            string error;
+            if (!readPoints(input_path, pts, distance_opts.num_threads, error))
+            {
+                cerr << input_path << ": " << error << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            /* Prompt user for the number of points. */
+            int num_points, i;
+            double x, y, z;
+
+            cout << "How many points?" << endl;
+            cin >> num_points;
+
+            /* Read in the specified number of points from STDIN. */
+            for (i = 0; i < num_points; i++)
+            {
+                cout << "Point " << i << ":" << endl;
+                cin >> x >> y >> z;
+                pts.push_back(Point(x, y, z));
+            }
+        }
+
+        cloud = buildPointCloud(pts);
+    }
+
+    /* Renumber the cities along a space-filling curve so that cities near
+       each other in space are near each other in memory.  A cost matrix
+       has no space to follow and keeps its numbering. */
+    std::vector<int> input_index;
+    if (from_matrix)
+    {
+        input_index.resize(dist->size());
+        for (int i = 0; i < dist->size(); i++)
+        {
+            input_index[i] = i;
+        }
+    }
+    else
+    {
+        input_index = spaceCurveOrder(cloud, curve);
+        if (curve != CURVE_NONE)
+        {
+            cloud = permutePointCloud(cloud, input_index);
+        }
+
+        /* Set up the requested distance lookup over the points. */
+        std::string error;
+        if (!checkDistanceKind(distance_opts.kind, cloud.size(), error))
+        {
+            cerr << error << endl;
+            return 1;
+        }
+        dist = makeDistanceStore(distance_opts, cloud);
     }
 
     /* Find a short Hamiltonian cycle using our genetic algorithm. */
-    TSPGenome g = findAShortPath(pts, population_size, num_generations,
-        keep * population_size, mutate * population_size);
+    GAOptions ga_opts;
+    ga_opts.population_size = population_size;
+    ga_opts.num_generations = num_generations;
+    ga_opts.keep_population = keep * population_size;
+    ga_opts.num_mutations = mutate * population_size;
+    ga_opts.num_threads = distance_opts.num_threads;
+    ga_opts.schedule = schedule;
+    ga_opts.chunk = chunk;
+    ga_opts.islands = island_opts.islands;
+    ga_opts.migration_interval = island_opts.migration_interval;
+    ga_opts.migrants = island_opts.migrants;
+    ga_opts.migration = island_opts.migration;
+    ga_opts.seed = seed;
+
+    /* Bound the optimum from below while the GA runs, over each city's
+       nearest neighbors. */
+    unique_ptr<OneTreeBound> bound;
+    if (lower_bound)
+    {
+        std::vector<int> neighbors;
+        if (from_matrix)
+        {
+            neighbors = nearestByCost(*dist, ONE_TREE_NEIGHBORS);
+        }
+        else
+        {
+            KDTree tree(cloud);
+            neighbors = tree.allKNearest(ONE_TREE_NEIGHBORS,
+                distance_opts.num_threads);
+        }
+        bound.reset(new OneTreeBound(*dist, neighbors, ONE_TREE_NEIGHBORS));
+        bound->start();
+        ga_opts.lower_bound = bound.get();
+        ga_opts.target_gap = target_gap;
+    }
 
-    /* Print the path and its cost to STDOUT. */
-    cout << "Best order:\t" << g.getOrder() << endl;
+    TSPGenome g = findAShortPath(*dist, ga_opts);
+    if (bound)
+    {
+        bound->stop();
+    }
+
+    /* Fix local disorder the GA left behind with exact windows. */
+    if (polish_window > 0)
+    {
+        std::vector<int> polished = g.getOrder();
+        PolishStats stats;
+
+        polishTour(*dist, polished, polish_window, distance_opts.num_threads,
+            &stats);
+        g = TSPGenome(polished);
+        g.computeCircuitLength(*dist);
+
+        cout << "Polished:\t" << stats.initial_length << " -> "
+            << stats.final_length << "\t("
+            << 100.0 * (stats.initial_length - stats.final_length) / stats.initial_length
+            << "% shorter; " << stats.improved << " of " << stats.windows
+            << " windows improved in " << stats.passes << " passes, "
+            << stats.seconds << " s)" << endl;
+    }
+
+    /* Print the path, in input numbering, and its cost to STDOUT. */
+    std::vector<int> order = g.getOrder();
+    for (int &city : order)
+    {
+        city = input_index[city];
+    }
+    cout << "Best order:\t" << order << endl;
     cout << "Shortest distance:\t" << g.getCircuitLength() << endl;
+    cout << "Seed:\t" << seed << endl;
 
-    return 0;
-}
+    if (bound && bound->bound() > 0.0)
+    {
+        /* A bound that meets the tour may exceed it by a rounding error. */
+        double gap = std::max(0.0, g.getCircuitLength() - bound->bound());
 
-/*! Comparator function for comparing the fitnesses of two different genomes. */
-static bool isShorterPath(const TSPGenome &g1, const TSPGenome &g2)
-{
-    return (g1.getCircuitLength() < g2.getCircuitLength());
+        cout << "Lower bound:\t" << bound->bound() << "\t(gap "
+            << 100.0 * gap / bound->bound() << "%, " << bound->steps() << " ascent steps"
+            << (bound->converged() ? ", converged" : "") << ")" << endl;
+    }
+
+    /* Lossy stores saw slightly different edge lengths, so the fitness above
+       is approximate; report the exact length and the difference. */
+    if (!from_matrix && isLossyDistanceKind(distance_opts.kind))
+    {
+        TSPGenome exact = g;
+        exact.computeCircuitLength(EuclideanDistances(cloud));
+
+        /* A tour of length 0 (all cities in one place) is stored exactly. */
+        double relative = exact.getCircuitLength() > 0.0
+            ? (g.getCircuitLength() - exact.getCircuitLength())
+            / exact.getCircuitLength() : 0.0;
+
+        cout << "Exact distance:\t" << exact.getCircuitLength()
+            << "\t(relative error " << relative << ", "
+            << dist->memoryBytes() << " bytes)" << endl;
+    }
+
+    return 0;
 }
 
-/*! Genetic algorithm for finding a short Hamiltonian cycle in POINTS. */
-static TSPGenome findAShortPath(const std::vector<Point> &points,
-    int populationSize, int numGenerations, int keepPopulation, int numMutations)
+/*! Rebuilds the table of type TABLE in DIST for the points of CLOUD in place,
+    or creates it if DIST is empty. */
+template<class Table>
+static void assignTable(std::unique_ptr<DistanceStore> &dist,
+    const PointCloud &cloud)
 {
-    std::vector<TSPGenome> genomes;
-    int i, gen;
-
-    /*! Create an initial population of random genomes and record their
-        fitnesses. */
-    for (i = 0; i < populationSize; i++)
+    if (dist)
+    {
+        static_cast<Table &>(*dist).assign(cloud, 1);
+    }
+    else
     {
-        TSPGenome genome = TSPGenome(points.size());
-        genomes.push_back(genome);
-        genome.computeCircuitLength(points);
+        dist.reset(new Table(cloud, 1));
     }
+}
 
-    gen = 1;
-    while (gen <= numGenerations)
+/*! Points WORKER's distance store of kind KIND at its current cloud,
+    reusing the store it already has. */
+static void buildBatchStore(DistanceKind kind, BatchWorker &worker)
+{
+    switch (kind)
     {
-        /* Every 10 generations, print out the shortest distance found so far. */
-        if (gen % 10 == 0)
-        {
-            std::cout << "Generation " << gen << ": shortest path is "
-                << genomes[0].getCircuitLength() << std::endl;
-        }
+    case DISTANCES_MATRIX:
+        assignTable<DistanceMatrix>(worker.dist, worker.cloud);
+        break;
 
-        /* Sort the population by fitness. */
-        std::sort(genomes.begin(), genomes.end(), isShorterPath);
+    case DISTANCES_FLOAT:
+        assignTable<FloatDistanceMatrix>(worker.dist, worker.cloud);
+        break;
 
-        /* Replace all but the top KEEP_POPULATION genomes in the population. */
-        for (i = keepPopulation; i < populationSize; i++)
-        {
-            int g1, g2;
-            g1 = g2 = 0;
-            while (g1 == g2)
-            {
-                g1 = rand() % keepPopulation;
-                g2 = rand() % keepPopulation;
-            }
+    case DISTANCES_INT16:
+        assignTable<QuantizedDistanceMatrix>(worker.dist, worker.cloud);
+        break;
 
-            /* Replace each inferior genome with a crosslink between two superior ones. */
-            genomes[i] = crosslink(genomes[g1], genomes[g2]);
-        }
+    case DISTANCES_DENSE:
+        assignTable<DenseDistances>(worker.dist, worker.cloud);
+        break;
 
-        /* Apply the specified number of mutations to the population. */
-        for (i = 0; i < numMutations; i++)
+    default:
+        /* Computed on demand from the worker's cloud, which stays put. */
+        if (!worker.dist)
         {
-            int mut_idx = 1 + rand() % (populationSize - 1);
-            genomes[mut_idx].mutate();
+            worker.dist.reset(new EuclideanDistances(worker.cloud));
         }
+        break;
+    }
+}
+
+/*! Solves every instance in the file at PATH with the GA, and polishes the
+    result if POLISH_WINDOW is set.  Threads claim instances from a shared
+    counter, one at a time, and each keeps its cloud, distance table and
+    population for the next instance.  Prints the tours in input order on
+    stdout and the throughput on stderr.  Returns the exit status. */
+static int solveBatch(const char *path, GAOptions ga_opts,
+    const DistanceOptions &distance_opts, int polish_window)
+{
+    using namespace std;
 
-        /* Recompute all circuit lengths after mutation. */
-        for (i = 0; i < populationSize; i++)
+    vector<vector<Point> > instances;
+    string error;
+    if (!readInstances(path, instances, error))
+    {
+        cerr << path << ": " << error << endl;
+        return 1;
+    }
+    for (int k = 0; k < (int) instances.size(); k++)
+    {
+        if (!checkDistanceKind(distance_opts.kind, instances[k].size(), error))
         {
-            genomes[i].computeCircuitLength(points);
+            cerr << path << ": instance " << k + 1 << ": " << error << endl;
+            return 1;
         }
-        gen++;
     }
 
-    /* Return the fittest genome. */
-    return genomes[0];
-}
+    auto start = chrono::steady_clock::now();
+    int num_instances = instances.size();
+    int num_threads = max(1, min(distance_opts.num_threads, num_instances));
+    vector<BatchWorker> workers(num_threads);
+    vector<BatchResult> results(num_instances);
+    atomic<int> next_instance(0);
+    long long num_cities = 0;
+
+    auto work = [&](int id) {
+        BatchWorker &worker = workers[id];
+        GAOptions opts = ga_opts;
+        int k;
+
+        opts.storage = &worker.storage;
+        while ((k = next_instance++) < num_instances)
+        {
+            BatchResult &result = results[k];
 
-/*! Crosses two genomes G1 and G2 and returns a new genome with an ordering that
-    derives from both G1 and G2.*/
-static TSPGenome crosslink(const TSPGenome &g1, const TSPGenome &g2)
-{
-    std::vector<int> new_order;
-    std::unordered_set<int> g1_chosen;
+            /* Each instance has a seed of its own, so its tour does not
+               depend on which thread solves it, or after what. */
+            opts.seed = deriveSeed(ga_opts.seed, k);
 
-    int i, j, elem;
+            worker.cloud = buildPointCloud(instances[k]);
+            buildBatchStore(distance_opts.kind, worker);
 
-    /* Choose a splitting point in the first genome. */
-    i = rand() % g1.getOrder().size();
+            if (worker.cloud.size() < 3)
+            {
+                /* Every order is a shortest one. */
+                result.order.resize(worker.cloud.size());
+                for (int i = 0; i < worker.cloud.size(); i++)
+                {
+                    result.order[i] = i;
+                }
+            }
+            else
+            {
+                result.order = findAShortPath(*worker.dist, opts).getOrder();
+                if (polish_window > 0)
+                {
+                    polishTour(*worker.dist, result.order, polish_window, 1);
+                }
+            }
+            /* An empty instance has no tour to measure. */
+            result.length = result.order.empty()
+                ? 0.0 : worker.dist->tourLength(result.order);
+        }
+    };
 
-    for (j = 0; j <= i; j++)
+    vector<thread> threads;
+    for (int t = 1; t < num_threads; t++)
     {
-        elem = g1.getOrder()[j];
-        new_order.push_back(elem);
-        g1_chosen.insert(elem);
+        threads.push_back(thread(work, t));
     }
+    work(0);
+    for (thread &t : threads)
+    {
+        t.join();
+    }
+
+    double seconds = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
 
-    /*! Put all points in G2 into the new ordering that weren't already obtained
-        from G1. */
-    for (j = 0; j < g2.getOrder().size(); j++)
+    for (int k = 0; k < num_instances; k++)
     {
-        elem = g2.getOrder()[j];
-        if (g1_chosen.find(elem) == g1_chosen.end())
-        {
-            /* This element was not inserted before, let's insert it. */
-            new_order.push_back(elem);
-        }
+        cout << "Instance " << k + 1 << ":\t" << results[k].length << "\t"
+            << results[k].order << endl;
+        num_cities += results[k].order.size();
     }
 
-    return TSPGenome(new_order);
+    cerr << "Solved " << num_instances << " instances (" << num_cities
+        << " cities) in " << seconds << " s on " << num_threads
+        << " threads: " << num_instances / seconds << " instances/s (seed "
+        << ga_opts.seed << ")" << endl;
+
+    return 0;
 }